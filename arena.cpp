@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cstdint>
+#include "arena.h"
+
+til::arena::~arena() {
+  for (auto it = _destructors.rbegin(); it != _destructors.rend(); ++it) {
+    it->second(it->first);
+  }
+}
+
+til::arena &til::arena::instance() {
+  static arena _self;
+  return _self;
+}
+
+void *til::arena::allocate(size_t size, size_t align) {
+  size_t padding = (align - reinterpret_cast<uintptr_t>(_next) % align) % align;
+
+  if (_next == nullptr || static_cast<size_t>(_end - _next) < padding + size) {
+    size_t chunk = std::max(CHUNK_SIZE, size + align);
+    if (_spare.first && _spare.second >= chunk) {
+      _chunks.push_back(std::move(_spare));
+      chunk = _chunks.back().second;
+    } else {
+      _chunks.emplace_back(new char[chunk], chunk);
+    }
+    _capacity += chunk;
+    _next = _chunks.back().first.get();
+    _end = _next + chunk;
+    padding = (align - reinterpret_cast<uintptr_t>(_next) % align) % align;
+  }
+
+  void *p = _next + padding;
+  _next += padding + size;
+  _bytes += size;
+  return p;
+}
+
+void til::arena::release(const position &p) {
+  while (_destructors.size() > p.destructors) {
+    _destructors.back().second(_destructors.back().first);
+    _destructors.pop_back();
+  }
+  // keep one chunk: releasing each declaration would otherwise free and allocate one every time
+  while (_chunks.size() > p.chunks) {
+    _capacity -= _chunks.back().second;
+    _spare = std::move(_chunks.back());
+    _chunks.pop_back();
+  }
+  _next = p.next;
+  _end = p.end;
+  _released += _bytes - p.bytes;
+  _bytes = p.bytes;
+}
+
+void til::arena::report(std::ostream &os) const {
+  os << "arena: " << _nodes << " nodes, " << _bytes << " bytes used, "
+     << _capacity << " bytes in " << _chunks.size() << " chunks";
+  if (_released > 0) os << ", " << _released << " bytes released";
+  os << std::endl;
+}
@@ -0,0 +1,125 @@
+#ifndef __TIL_ARENA_H__
+#define __TIL_ARENA_H__
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace til {
+
+  /**
+   * Bump allocator for the syntax tree and the parser's semantic values.
+   * Memory is not returned piecemeal: everything allocated after a given
+   * position is released at once (see release()), and the rest when the
+   * arena is destroyed at the end of the compilation.
+   */
+  class arena {
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::pair<std::unique_ptr<char[]>, size_t>> _chunks; // with their sizes
+    std::pair<std::unique_ptr<char[]>, size_t> _spare;                // last chunk released
+    char *_next = nullptr;
+    char *_end = nullptr;
+    size_t _capacity = 0; // bytes reserved in chunks
+    size_t _bytes = 0;    // bytes handed out
+    size_t _released = 0; // bytes handed out and then released
+    size_t _nodes = 0;    // syntax tree nodes created
+    bool _destroy_nodes = false;
+    std::vector<std::pair<void*, void (*)(void*)>> _destructors;
+
+  public:
+    /** A point in the allocation sequence (see mark() and release()). */
+    struct position {
+      size_t chunks = 0;
+      char *next = nullptr;
+      char *end = nullptr;
+      size_t bytes = 0;
+      size_t destructors = 0;
+    };
+
+  public:
+    arena() = default;
+    arena(const arena&) = delete;
+    arena &operator=(const arena&) = delete;
+    ~arena();
+
+    /** The arena of the current compilation. */
+    static arena &instance();
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    /**
+     * Create a syntax tree node. Nodes are not destroyed individually:
+     * cdk::sequence_node deletes its children, which must not happen to
+     * arena memory, so only their storage is reclaimed -- unless
+     * destroy_nodes() was called, in which case sequences forget their
+     * children before being destroyed with the arena memory they live in.
+     */
+    template<typename T, typename... Args>
+    T *node(Args&&... args) {
+      _nodes++;
+      T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+      if (_destroy_nodes) {
+        _destructors.emplace_back(object, [](void *p) {
+          if constexpr (requires(T &node) { node.nodes().clear(); }) {
+            static_cast<T*>(p)->nodes().clear();
+          }
+          static_cast<T*>(p)->~T();
+        });
+      }
+      return object;
+    }
+
+    /** Create any other object; it is destroyed together with the arena. */
+    template<typename T, typename... Args>
+    T *make(Args&&... args) {
+      T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+      if constexpr (!std::is_trivially_destructible_v<T>) {
+        _destructors.emplace_back(object, [](void *p) { static_cast<T*>(p)->~T(); });
+      }
+      return object;
+    }
+
+    /**
+     * Destroy the nodes created from now on when their memory is released,
+     * so that releasing a subtree also frees the types and strings it holds.
+     */
+    void destroy_nodes() {
+      _destroy_nodes = true;
+    }
+
+    /** The current position: everything allocated after it can be released. */
+    position mark() const {
+      return { _chunks.size(), _next, _end, _bytes, _destructors.size() };
+    }
+
+    /**
+     * Destroy the objects created after the given position and reuse their
+     * memory. Nothing allocated after it may be in use.
+     */
+    void release(const position &p);
+
+    size_t nodes() const {
+      return _nodes;
+    }
+    size_t bytes() const {
+      return _bytes;
+    }
+    size_t capacity() const {
+      return _capacity;
+    }
+    size_t released() const {
+      return _released;
+    }
+
+    /** Debug summary: node count and arena usage. */
+    void report(std::ostream &os) const;
+  };
+
+} // til
+
+#endif
@@ -4,6 +4,7 @@
 #include <cdk/ast/expression_node.h>
 #include <cdk/ast/typed_node.h>
 #include <cdk/types/basic_type.h>
+#include "interner.h"
 
 namespace til {
 
@@ -12,13 +13,13 @@ namespace til {
    */
   class declaration_node : public cdk::typed_node {
     int _qualifier;
-    std::string _identifier;
+    const std::string *_identifier; // interned
     cdk::expression_node *_initialValue;
 
   public:
     declaration_node(int lineno, int qualifier, std::shared_ptr<cdk::basic_type> varType, const std::string &identifier,
                       cdk::expression_node *initialValue) :
-        cdk::typed_node(lineno), _qualifier(qualifier), _identifier(identifier), _initialValue(initialValue) {
+        cdk::typed_node(lineno), _qualifier(qualifier), _identifier(&til::interner::instance().intern(identifier)), _initialValue(initialValue) {
       type(varType);
     }
 
@@ -27,7 +28,7 @@ namespace til {
     }
 
     const std::string &identifier() const {
-      return _identifier;
+      return *_identifier;
     }
 
     cdk::expression_node *initialValue() {
@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Native code: compile the program of nested numeric loops (see bench/tilgen.sh)
+# for the postfix target (ix86) and for asm64 (x86-64, values in registers), link
+# and run both, check that they print the same, and report the instructions and
+# branches each executes (perf stat), its running time, and the reduction.
+# Usage: bench/asm64.sh [iterations]   (run from the top directory, after make)
+#   TIL=./til  RTS=$HOME/compiladores/root/usr/lib  RTS64=$HOME/compiladores/root/usr/lib64
+#
+
+. "$(dirname "$0")/common.sh"
+RTS64=${RTS64:-$HOME/compiladores/root/usr/lib64}
+
+iterations=${1:-20000}
+
+src="$TMP/loops.til"
+sh "$dir/tilgen.sh" loops "$iterations" > "$src" || exit 1
+
+build "$TIL" "$src" asm
+
+"$TIL" --target asm64 "$src" -o "$TMP/asm64.asm" || exit 1
+yasm -felf64 -o "$TMP/asm64.o" "$TMP/asm64.asm" || exit 1
+ld -m elf_x86_64 -o "$TMP/asm64" "$TMP/asm64.o" -L"$RTS64" -lrts || exit 1
+
+postfix=$(measure asm)
+native=$(measure asm64)
+cmp -s "$TMP/asm.out" "$TMP/asm64.out" || { echo "outputs differ"; exit 1; }
+
+printf '%-10s %14s %14s %10s\n' target instructions branches seconds
+echo "asm $postfix" | awk '{ printf "%-10s %14s %14s %10.3f\n", $1, $2, $3, $4 }'
+echo "asm64 $native" | awk '{ printf "%-10s %14s %14s %10.3f\n", $1, $2, $3, $4 }'
+echo "$postfix $native" | awk '{
+  if ($1 != "-") printf "instructions -%.1f%%  branches -%.1f%%  ", 100 * (1 - $4 / $1), 100 * (1 - $5 / $2);
+  printf "time -%.1f%%\n", 100 * (1 - $6 / $3) }'
@@ -0,0 +1,46 @@
+#
+# Shared by the benchmarks, which source it first:  . "$(dirname "$0")/common.sh"
+# Sets TIL, RTS and dir (the benchmarks' directory), makes the scratch
+# directory TMP (removed on exit) and defines the helpers below.
+#   TIL=./til  RTS=$HOME/compiladores/root/usr/lib
+#
+
+TIL=${TIL:-./til}
+RTS=${RTS:-$HOME/compiladores/root/usr/lib}
+TMP=${TMPDIR:-/tmp}/til-bench-$$
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+dir=$(dirname "$0")
+
+# seconds <command...>: run a command and print its wall-clock time
+seconds() {
+  start=$(date +%s.%N)
+  "$@" || exit 1
+  end=$(date +%s.%N)
+  echo "$start $end" | awk '{ printf "%.3f", $2 - $1 }'
+}
+
+# build <compiler> <source> <name>: compile for the asm target, assemble and link $TMP/<name>
+build() {
+  "$1" --target asm "$2" -o "$TMP/$3.asm" || exit 1
+  yasm -felf32 -o "$TMP/$3.o" "$TMP/$3.asm" || exit 1
+  ld -m elf_i386 -o "$TMP/$3" "$TMP/$3.o" -L"$RTS" -lrts || exit 1
+}
+
+# measure <name>: run $TMP/<name> (its output goes to $TMP/<name>.out) and
+# print "instructions branches seconds" (perf stat; "-" without perf)
+measure() {
+  if command -v perf > /dev/null 2>&1; then
+    perf stat -x, -e instructions,branches -o "$TMP/$1.perf" "$TMP/$1" > "$TMP/$1.out" || exit 1
+    instructions=$(awk -F, '$3 ~ /^instructions/ { print $1 }' "$TMP/$1.perf")
+    branches=$(awk -F, '$3 ~ /^branches/ { print $1 }' "$TMP/$1.perf")
+  else
+    instructions=-
+    branches=-
+  fi
+  start=$(date +%s.%N)
+  "$TMP/$1" > "$TMP/$1.out" || exit 1
+  end=$(date +%s.%N)
+  echo "$instructions $branches $(echo "$start $end" | awk '{ print $2 - $1 }')"
+}
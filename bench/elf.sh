@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Direct object emission: compile synthetic programs (see bench/tilgen.sh) to an
+# object both ways, "--target asm" followed by yasm and "--target elf", and
+# report the seconds each takes; then link the loops program both ways with the
+# runtime and check that the two executables print the same.
+# Usage: bench/elf.sh [kind:size...]   (run from the top directory, after make)
+#   TIL=./til  RTS=$HOME/compiladores/root/usr/lib
+#
+
+. "$(dirname "$0")/common.sh"
+
+[ $# -eq 0 ] && set -- functions:10000 mixed:10000 flat:100000
+
+printf '%-10s %8s %10s %10s %10s %10s\n' kind size til yasm "til+yasm" elf
+for case in "$@"; do
+  kind=${case%%:*}
+  size=${case#*:}
+  src="$TMP/$kind-$size.til"
+  sh "$dir/tilgen.sh" "$kind" "$size" > "$src" || exit 1
+
+  compile=$(seconds "$TIL" --target asm "$src" -o "$TMP/out.asm")
+  assemble=$(seconds yasm -felf32 -o "$TMP/asm.o" "$TMP/out.asm")
+  direct=$(seconds "$TIL" --target elf "$src" -o "$TMP/elf.o")
+  echo "$kind $size $compile $assemble $direct" |
+    awk '{ printf "%-10s %8s %10.3f %10.3f %10.3f %10.3f\n", $1, $2, $3, $4, $3 + $4, $5 }'
+done
+
+src="$TMP/loops.til"
+sh "$dir/tilgen.sh" loops 100 > "$src" || exit 1
+build "$TIL" "$src" asm
+"$TIL" --target elf "$src" -o "$TMP/elf.o" || exit 1
+ld -m elf_i386 -o "$TMP/elf" "$TMP/elf.o" -L"$RTS" -lrts || exit 1
+for o in asm elf; do
+  "$TMP/$o" > "$TMP/$o.out" || exit 1
+done
+cmp -s "$TMP/asm.out" "$TMP/elf.out" || { echo "outputs differ"; exit 1; }
+echo "loops: same output"
@@ -0,0 +1,32 @@
+#!/bin/sh
+#
+# Loop code: compile a program of nested numeric loops (see bench/tilgen.sh),
+# link and run it, and report the instructions and branches it executes
+# (perf stat) and its running time. With TIL_BASELINE set to another build
+# of the compiler (e.g. one from before loop rotation), both are measured,
+# their outputs compared, and the reduction reported.
+# Usage: bench/loops.sh [iterations]   (run from the top directory, after make)
+#   TIL=./til  TIL_BASELINE=  RTS=$HOME/compiladores/root/usr/lib
+#
+
+. "$(dirname "$0")/common.sh"
+
+iterations=${1:-20000}
+
+src="$TMP/loops.til"
+sh "$dir/tilgen.sh" loops "$iterations" > "$src" || exit 1
+
+build "$TIL" "$src" current
+current=$(measure current)
+printf '%-10s %14s %14s %10s\n' compiler instructions branches seconds
+echo "current $current" | awk '{ printf "%-10s %14s %14s %10.3f\n", $1, $2, $3, $4 }'
+
+[ -n "$TIL_BASELINE" ] || exit 0
+
+build "$TIL_BASELINE" "$src" baseline
+baseline=$(measure baseline)
+echo "baseline $baseline" | awk '{ printf "%-10s %14s %14s %10.3f\n", $1, $2, $3, $4 }'
+cmp -s "$TMP/current.out" "$TMP/baseline.out" || { echo "outputs differ"; exit 1; }
+
+echo "$baseline $current" | awk '$1 != "-" {
+  printf "instructions -%.1f%%  branches -%.1f%%\n", 100 * (1 - $4 / $1), 100 * (1 - $5 / $2) }'
@@ -0,0 +1,55 @@
+// Throughput of the postfix output path: small formatted writes to an
+// std::ofstream, directly and through til::chunked_output.
+//
+//   make bench/output_sink   ("make bench" builds and runs it)
+//   bench/output_sink [lines] [file]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "targets/chunked_output.h"
+
+// the same kind of writes cdk::postfix_ix86_emitter does for INT/ADD/LABEL
+static void emit(std::ostream &os, long lines) {
+  for (long i = 0; i < lines; i++) {
+    switch (i % 4) {
+      case 0: os << "\tpush\tdword " << i << std::endl; break;
+      case 1: os << "\tpop\teax\n\tadd\tdword [esp], eax" << std::endl; break;
+      case 2: os << "_L" << i << ":" << std::endl; break;
+      default: os << "\tjmp\tdword _L" << i << std::endl; break;
+    }
+  }
+}
+
+static double run(const std::string &file, long lines, bool chunked) {
+  std::ofstream out(file);
+  std::ostream &os = out;
+  auto start = std::chrono::steady_clock::now();
+
+  if (chunked) {
+    til::chunked_output buffer(os.rdbuf());
+    os.rdbuf(&buffer);
+    emit(os, lines);
+    buffer.drain();
+    os.rdbuf(buffer.target());
+  } else {
+    emit(os, lines);
+    os.flush();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(out.tellp()) / elapsed.count() / (1024 * 1024);
+}
+
+int main(int argc, char *argv[]) {
+  long lines = argc > 1 ? std::atol(argv[1]) : 2000000;
+  std::string file = argc > 2 ? argv[2] : "output_sink.tmp";
+
+  std::cout << "stream  " << run(file, lines, false) << " MB/s" << std::endl;
+  std::cout << "chunked " << run(file, lines, true) << " MB/s" << std::endl;
+  std::remove(file.c_str());
+  return 0;
+}
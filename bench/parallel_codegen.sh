@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Parallel code generation: compile a file with many independent functions
+# with TIL_JOBS=1 and TIL_JOBS=<jobs>, check that both outputs are identical
+# and report the speedup.
+# Usage: bench/parallel_codegen.sh [functions] [jobs]   (run from the top directory, after make)
+#
+
+. "$(dirname "$0")/common.sh"
+
+count=${1:-5000}
+jobs=${2:-$(nproc)}
+
+src="$TMP/functions.til"
+sh "$dir/tilgen.sh" functions "$count" > "$src" || exit 1
+
+# run <jobs>: compile with that many code generation threads and print the seconds taken
+run() {
+  seconds env TIL_JOBS="$1" "$TIL" --target asm "$src" -o "$TMP/out-$1.asm"
+}
+
+serial=$(run 1)
+parallel=$(run "$jobs")
+
+cmp -s "$TMP/out-1.asm" "$TMP/out-$jobs.asm" || { echo "outputs differ"; exit 1; }
+echo "$count $jobs $serial $parallel" |
+  awk '{ printf "functions %d  serial %.3f s  %d jobs %.3f s  speedup %.2fx\n", $1, $3, $2, $4, $3 / $4 }'
@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Time each compiler phase on synthetic programs (see bench/tilgen.sh) and
+# append one JSON object per compilation to the results file:
+#   {"commit":..., "kind":..., "size":..., "bytes":..., "phases":{"scan":s, "parse":s,
+#    "check":s, "codegen":s, "emit":s, "flush":s, "xml":s, "total":s}}
+# With TIL_JOBS > 1, "codegen" adds up the time of all threads.
+# Each case runs BENCH_RUNS times (default 3); every run is recorded.
+#
+# Usage: bench/phases.sh [kind:size...]   (run from the top directory, after make)
+#   TIL=./til  BENCH_OUT=bench-results.jsonl  BENCH_RUNS=3
+#
+
+OUT=${BENCH_OUT:-bench-results.jsonl}
+RUNS=${BENCH_RUNS:-3}
+. "$(dirname "$0")/common.sh"
+
+[ $# -eq 0 ] && set -- nested:1000 nested:4000 flat:10000 flat:100000 functions:1000 functions:10000 \
+                       strings:2000 vars:20000 lambdas:50 lambdas:200 mixed:2000
+
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+for case in "$@"; do
+  kind=${case%%:*}
+  size=${case#*:}
+  src="$TMP/$kind-$size.til"
+  sh "$dir/tilgen.sh" "$kind" "$size" > "$src" || exit 1
+  bytes=$(wc -c < "$src" | tr -d ' ')
+
+  run=0
+  while [ $run -lt "$RUNS" ]; do
+    rm -f "$TMP/times"
+    TIL_TIMES="$TMP/times" "$TIL" --target asm "$src" -o "$TMP/out.asm" || { echo "$case: compilation failed" >&2; exit 1; }
+    phases=$(cat "$TMP/times")
+    printf '{"commit":"%s","kind":"%s","size":%s,"bytes":%s,"run":%d,"phases":%s}\n' \
+      "$commit" "$kind" "$size" "$bytes" "$run" "$phases" >> "$OUT"
+    run=$((run + 1))
+  done
+
+  # last run of each case, for the impatient reader
+  printf '%-10s %8s  %s\n' "$kind" "$size" "$phases"
+done
@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# Scanner throughput: scan synthetic programs (see bench/tilgen.sh) with the
+# flex scanner and with the SIMD scanner (TIL_SCANNER), check that both give
+# the same XML tree and report the scanning speed of each in MB/s (best of
+# BENCH_RUNS runs, default 3, as measured by the "scan" phase of TIL_TIMES).
+# Usage: bench/scanner.sh [kind:size...]   (run from the top directory, after make)
+#   TIL=./til  BENCH_RUNS=3  SCANNERS="flex scalar sse2 avx2"   (flex first: the others are checked against it)
+#
+
+RUNS=${BENCH_RUNS:-3}
+SCANNERS=${SCANNERS:-flex scalar sse2 avx2}
+. "$(dirname "$0")/common.sh"
+
+[ $# -eq 0 ] && set -- flat:100000 functions:10000 strings:5000 mixed:5000
+
+printf '%-10s %8s %10s' kind size bytes
+for scanner in $SCANNERS; do printf ' %9s' "$scanner"; done
+echo
+
+for case in "$@"; do
+  kind=${case%%:*}
+  size=${case#*:}
+  src="$TMP/$kind-$size.til"
+  sh "$dir/tilgen.sh" "$kind" "$size" > "$src" || exit 1
+  bytes=$(wc -c < "$src" | tr -d ' ')
+
+  printf '%-10s %8s %10s' "$kind" "$size" "$bytes"
+  for scanner in $SCANNERS; do
+    best=
+    run=0
+    while [ $run -lt "$RUNS" ]; do
+      rm -f "$TMP/times"
+      TIL_SCANNER=$scanner TIL_TIMES="$TMP/times" "$TIL" --target xml "$src" -o "$TMP/$scanner.xml" ||
+        { echo "$case: $scanner: compilation failed" >&2; exit 1; }
+      scan=$(sed 's/.*"scan":\([0-9.e+-]*\).*/\1/' "$TMP/times")
+      best=$(echo "$best $scan" | awk 'NF == 1 || $2 < $1 { print $NF; next } { print $1 }')
+      run=$((run + 1))
+    done
+    cmp -s "$TMP/flex.xml" "$TMP/$scanner.xml" 2>/dev/null || [ "$scanner" = flex ] ||
+      { echo; echo "$case: $scanner and flex trees differ" >&2; exit 1; }
+    echo "$bytes $best" | awk '{ printf " %9.1f", $2 > 0 ? $1 / $2 / 1e6 : 0 }'
+  done
+  echo
+done
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Streaming compilation: compile large synthetic programs (see bench/tilgen.sh)
+# with and without TIL_STREAM, check that both outputs are identical and
+# report the peak resident set size of each (from the TIL_STATS summary).
+# Usage: bench/streaming.sh [kind:size...]   (run from the top directory, after make)
+#
+
+. "$(dirname "$0")/common.sh"
+
+[ $# -eq 0 ] && set -- functions:10000 functions:50000 flat:100000 mixed:10000
+
+printf '%-10s %8s %10s %14s %14s\n' kind size bytes "peak kB" "streamed kB"
+for case in "$@"; do
+  kind=${case%%:*}
+  size=${case#*:}
+  src="$TMP/$kind-$size.til"
+  sh "$dir/tilgen.sh" "$kind" "$size" > "$src" || exit 1
+  bytes=$(wc -c < "$src" | tr -d ' ')
+
+  for stream in 0 1; do
+    TIL_STREAM=$stream TIL_STATS="$TMP/trace.json" "$TIL" --target asm "$src" -o "$TMP/out-$stream.asm" 2> "$TMP/stats-$stream" ||
+      { echo "$case: compilation failed" >&2; cat "$TMP/stats-$stream" >&2; exit 1; }
+  done
+  cmp -s "$TMP/out-0.asm" "$TMP/out-1.asm" || { echo "$case: outputs differ" >&2; exit 1; }
+
+  peak=$(sed -n 's/.*peak RSS \([0-9]*\) kB.*/\1/p' "$TMP/stats-0")
+  streamed=$(sed -n 's/.*peak RSS \([0-9]*\) kB.*/\1/p' "$TMP/stats-1")
+  printf '%-10s %8s %10s %14s %14s\n' "$kind" "$size" "$bytes" "$peak" "$streamed"
+done
@@ -0,0 +1,109 @@
+#!/bin/sh
+#
+# Synthetic TIL programs for benchmarking the compiler.
+# Usage: bench/tilgen.sh <kind> <size>   (writes the program to stdout)
+#
+#   nested     <size> levels of nested expressions: (+ (+ (+ ... 1) 1) 1)
+#   flat       <size> global variables and a program block with <size> instructions
+#   functions  <size> independent functions with loops and conditionals
+#   strings    <size> string literals of 1000 characters each
+#   vars       <size> "var" declarations whose types must be inferred
+#   lambdas    function literals nested <size> levels deep
+#   mixed      a bit of everything, <size> times: a "realistic" program
+#   loops      numeric nested loops, <size> outer iterations (to run, not just compile)
+#
+
+kind=$1
+size=$2
+[ -n "$kind" ] && [ -n "$size" ] || { echo "usage: $0 kind size" >&2; exit 2; }
+
+case $kind in
+nested)
+  awk -v n="$size" 'BEGIN {
+    printf "(program (println ";
+    for (i = 0; i < n; i++) printf "(+ ";
+    printf "1";
+    for (i = 0; i < n; i++) printf " 1)";
+    print "))";
+  }' ;;
+
+flat)
+  awk -v n="$size" 'BEGIN {
+    for (i = 0; i < n; i++) printf "(int g%d %d)\n", i, i;
+    print "(program";
+    for (i = 0; i < n; i++) printf "  (set g%d (+ g%d 1))\n", i, i;
+    print ")";
+  }' ;;
+
+functions)
+  awk -v n="$size" 'BEGIN {
+    for (i = 0; i < n; i++) {
+      printf "(public (int (int)) f%d (function (int (int n))\n", i;
+      printf "  (var s 0) (var k 0)\n";
+      printf "  (loop (< k n) (block (set s (+ s (* k %d))) (if (> s 1000) (set s (- s 1000))) (set k (+ k 1))))\n", i % 7 + 1;
+      printf "  (return s)))\n";
+    }
+    print "(program (println (f0 10)))";
+  }' ;;
+
+strings)
+  awk -v n="$size" 'BEGIN {
+    line = "";
+    for (j = 0; j < 100; j++) line = line "abcdefghi ";
+    print "(program";
+    for (i = 0; i < n; i++) printf "  (var s%d \"%d: %s\\n\")\n", i, i, line;
+    for (i = 0; i < n; i++) printf "  (print s%d)\n", i;
+    print ")";
+  }' ;;
+
+vars)
+  awk -v n="$size" 'BEGIN {
+    print "(program";
+    print "  (var v0 1)";
+    for (i = 1; i < n; i++) {
+      if (i % 3 == 0) printf "  (var v%d (+ v%d 0.5))\n", i, i - 1;
+      else if (i % 3 == 1) printf "  (var v%d (objects (+ 1 %d)))\n", i, i % 10;
+      else printf "  (var v%d (* v%d 2))\n", i, i - 2;
+    }
+    printf "  (println v%d)\n", n - 1 - (n - 1) % 3;
+    print ")";
+  }' ;;
+
+lambdas)
+  awk -v n="$size" 'BEGIN {
+    f = "(function (int (int x)) (return x))";
+    for (i = 0; i < n; i++) f = "(function (int (int x)) (return (+ x (" f " (- x 1)))))";
+    print "(program (var f " f ") (println (f 1)))";
+  }' ;;
+
+mixed)
+  awk -v n="$size" 'BEGIN {
+    print "(external (int (int)) printi)";
+    for (i = 0; i < n; i++) {
+      printf "(double d%d %d.5)\n", i, i;
+      printf "(forward (int (int int)) g%d)\n", i;
+      printf "(public (int (int int)) g%d (function (int (int a) (int b))\n", i;
+      printf "  (var t (objects 4))\n";
+      printf "  (set (index t 0) a) (set (index t 1) b)\n";
+      printf "  (if (< a b) (return (+ (index t 0) (index t 1))) (return (- a b)))))\n";
+      printf "(public (double) h%d (function (double) (var k (function (double (double y)) (return (* y 2.0)))) (return (k d%d))))\n", i, i;
+    }
+    print "(program (var i 0)";
+    printf "  (loop (< i %d) (block (println (g0 i 2) \" \" (h0)) (set i (+ i 1)) (if (== i 3) (next))))\n", n;
+    print "  (return 0))";
+  }' ;;
+
+loops)
+  awk -v n="$size" 'BEGIN {
+    print "(program (var s 0) (var d 0.0) (var i 0)";
+    printf "  (loop (< i %d) (block (var j 0)\n", n;
+    print "    (loop (&& (< j 1000) (>= s 0)) (block (set s (+ s j)) (if (> s 1000000) (set s 0)) (set j (+ j 1))))";
+    print "    (loop (< d i) (set d (+ d 0.5)))";
+    print "    (set i (+ i 1))))";
+    print "  (println s \" \" d)";
+    print "  (return 0))";
+  }' ;;
+
+*)
+  echo "$0: unknown kind '$kind'" >&2; exit 2 ;;
+esac
@@ -0,0 +1,15 @@
+#include "interner.h"
+
+til::interner &til::interner::instance() {
+  static interner _self;
+  return _self;
+}
+
+void til::interner::report(std::ostream &os) const {
+  size_t bytes = 0;
+  for (auto &s : _strings) {
+    bytes += s.size();
+  }
+  os << "interner: " << _strings.size() << " distinct strings (" << bytes << " bytes) for "
+     << _requests << " requests" << std::endl;
+}
@@ -0,0 +1,64 @@
+#ifndef __TIL_INTERNER_H__
+#define __TIL_INTERNER_H__
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace til {
+
+  /**
+   * Compiler-wide string table: identifiers are stored once per distinct
+   * value (string literals are not interned: see the scanners). Interned
+   * strings never move, so their address identifies them: two interned
+   * names are equal iff they are the same object.
+   */
+  class interner {
+    struct hash {
+      using is_transparent = void;
+      size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>()(s);
+      }
+    };
+
+    std::unordered_set<std::string, hash, std::equal_to<>> _strings;
+    size_t _requests = 0;
+    std::mutex _mutex; // code generation threads create symbols too
+
+  public:
+    interner() = default;
+    interner(const interner&) = delete;
+    interner &operator=(const interner&) = delete;
+
+    /** The string table of the current compilation. */
+    static interner &instance();
+
+    /** @return the unique copy of the given string */
+    const std::string &intern(std::string_view s) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _requests++;
+      auto it = _strings.find(s);
+      if (it == _strings.end()) {
+        it = _strings.emplace(s).first;
+      }
+      return *it;
+    }
+
+    size_t size() const {
+      return _strings.size();
+    }
+    size_t requests() const {
+      return _requests;
+    }
+
+    /** Debug summary: distinct strings and bytes stored. */
+    void report(std::ostream &os) const;
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <unordered_set>
+#include "ir/ir.h"
+
+//---------------------------------------------------------------------------
+
+const char *til::ir::name(type t) {
+  switch (t) {
+    case type::VOID: return "void";
+    case type::INT: return "int";
+    case type::DOUBLE: return "double";
+    case type::POINTER: return "ptr";
+    case type::FUNCTION: return "fn";
+  }
+  return "?";
+}
+
+const char *til::ir::name(op o) {
+  switch (o) {
+    case op::CONST: return "const";
+    case op::ADDRESS: return "address";
+    case op::SLOT: return "slot";
+    case op::PARAM: return "param";
+    case op::LOAD: return "load";
+    case op::STORE: return "store";
+    case op::ALLOC: return "alloc";
+    case op::ADD: return "add";
+    case op::SUB: return "sub";
+    case op::MUL: return "mul";
+    case op::DIV: return "div";
+    case op::MOD: return "mod";
+    case op::NEG: return "neg";
+    case op::AND: return "and";
+    case op::OR: return "or";
+    case op::CMP: return "cmp";
+    case op::I2D: return "i2d";
+    case op::CALL: return "call";
+    case op::PHI: return "phi";
+    case op::JUMP: return "jump";
+    case op::BRANCH: return "branch";
+    case op::RETURN: return "return";
+  }
+  return "?";
+}
+
+const char *til::ir::name(cond c) {
+  switch (c) {
+    case cond::EQ: return "eq";
+    case cond::NE: return "ne";
+    case cond::LT: return "lt";
+    case cond::LE: return "le";
+    case cond::GT: return "gt";
+    case cond::GE: return "ge";
+  }
+  return "?";
+}
+
+til::ir::cond til::ir::negate(cond c) {
+  switch (c) {
+    case cond::EQ: return cond::NE;
+    case cond::NE: return cond::EQ;
+    case cond::LT: return cond::GE;
+    case cond::LE: return cond::GT;
+    case cond::GT: return cond::LE;
+    case cond::GE: return cond::LT;
+  }
+  return c;
+}
+
+//---------------------------------------------------------------------------
+
+std::vector<til::ir::block*> til::ir::block::successors() const {
+  instruction *last = terminator();
+  return last == nullptr ? std::vector<block*>{} : last->targets;
+}
+
+//---------------------------------------------------------------------------
+
+til::ir::block *til::ir::function::add_block() {
+  return _blocks.emplace_back(std::make_unique<block>()).get();
+}
+
+til::ir::block *til::ir::function::add_block_after(block *after) {
+  auto it = std::find_if(_blocks.begin(), _blocks.end(), [after](auto &b) { return b.get() == after; });
+  return _blocks.insert(it == _blocks.end() ? it : it + 1, std::make_unique<block>())->get();
+}
+
+void til::ir::function::place(block *b) {
+  auto it = std::find_if(_blocks.begin(), _blocks.end(), [b](auto &p) { return p.get() == b; });
+  if (it == _blocks.end()) return;
+  std::unique_ptr<block> moved = std::move(*it);
+  _blocks.erase(it);
+  _blocks.push_back(std::move(moved));
+}
+
+til::ir::instruction *til::ir::function::make(op code, type t, const std::vector<instruction*> &operands) {
+  instruction *ins = _values.emplace_back(std::make_unique<instruction>()).get();
+  ins->code = code;
+  ins->type = t;
+  ins->operands = operands;
+  ins->id = ++_ids;
+  return ins;
+}
+
+til::ir::instruction *til::ir::function::append(block *b, op code, type t, const std::vector<instruction*> &operands) {
+  instruction *ins = make(code, t, operands);
+  ins->parent = b;
+  b->code.push_back(ins);
+  return ins;
+}
+
+std::unordered_map<const til::ir::block*, std::vector<til::ir::block*>> til::ir::function::predecessors() const {
+  std::unordered_map<const block*, std::vector<block*>> preds;
+  for (auto &b : _blocks) {
+    preds[b.get()]; // every block has an entry, even without predecessors
+    for (block *s : b->successors()) {
+      auto &list = preds[s];
+      if (std::find(list.begin(), list.end(), b.get()) == list.end()) list.push_back(b.get());
+    }
+  }
+  return preds;
+}
+
+std::unordered_map<const til::ir::instruction*, size_t> til::ir::function::uses() const {
+  std::unordered_map<const instruction*, size_t> count;
+  for (auto &b : _blocks) {
+    for (instruction *ins : b->code) {
+      for (instruction *operand : ins->operands) {
+        count[operand]++;
+      }
+    }
+  }
+  return count;
+}
+
+void til::ir::function::replace(const std::unordered_map<instruction*, instruction*> &by) {
+  if (by.empty()) return;
+
+  // follow chains (a by b, b by c), so that the result does not depend on the order of the map
+  auto final = [&by](instruction *ins) {
+    for (auto it = by.find(ins); it != by.end(); it = by.find(ins)) ins = it->second;
+    return ins;
+  };
+  for (auto &b : _blocks) {
+    for (instruction *ins : b->code) {
+      for (instruction *&operand : ins->operands) {
+        operand = final(operand);
+      }
+    }
+  }
+}
+
+void til::ir::function::renumber() {
+  int blocks = 0, values = 0;
+  for (auto &b : _blocks) {
+    b->id = blocks++;
+    for (instruction *ins : b->code) {
+      ins->id = ++values;
+      ins->parent = b.get();
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::function::verify() const {
+  std::unordered_set<const block*> blocks;
+  std::unordered_set<const instruction*> placed;
+  for (auto &b : _blocks) {
+    blocks.insert(b.get());
+    placed.insert(b->code.begin(), b->code.end());
+  }
+
+  auto preds = predecessors();
+  for (auto &b : _blocks) {
+    const std::string where = _name + ", b" + std::to_string(b->id) + ": ";
+    if (b->terminator() == nullptr) throw where + "block does not end in a jump, branch or return";
+
+    bool phis = true;
+    for (size_t k = 0; k < b->code.size(); k++) {
+      instruction *ins = b->code[k];
+      if (ins->parent != b.get()) throw where + "%" + std::to_string(ins->id) + " is in another block";
+      if (ins->terminator() && k + 1 != b->code.size()) throw where + "terminator before the end of the block";
+      if (ins->code == op::PHI && !phis) throw where + "phi after other instructions";
+      phis = phis && ins->code == op::PHI;
+
+      for (instruction *operand : ins->operands) {
+        if (placed.count(operand) == 0) throw where + "%" + std::to_string(ins->id) + " uses a value not in the function";
+        if (operand->type == type::VOID) throw where + "%" + std::to_string(ins->id) + " uses a void value";
+      }
+      for (block *target : ins->targets) {
+        if (blocks.count(target) == 0) throw where + "%" + std::to_string(ins->id) + " refers to a block not in the function";
+      }
+      if (ins->code == op::PHI) {
+        auto &from = preds[b.get()];
+        if (ins->targets.size() != ins->operands.size() || ins->targets.size() != from.size()
+            || !std::is_permutation(from.begin(), from.end(), ins->targets.begin())) {
+          throw where + "phi %" + std::to_string(ins->id) + " does not match the predecessors of its block";
+        }
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::function::print(std::ostream &os) const {
+  os << "function " << _name << " (";
+  for (size_t k = 0; k < _params.size(); k++) {
+    os << (k ? ", " : "") << ir::name(_params[k]);
+  }
+  os << ") -> " << ir::name(_result) << (_exported ? " exported" : "") << '\n';
+
+  for (auto &b : _blocks) {
+    os << "  b" << b->id << ":\n";
+    for (instruction *ins : b->code) {
+      os << "    ";
+      if (ins->type != type::VOID) os << '%' << ins->id << " = ";
+      os << ir::name(ins->code);
+      if (ins->type != type::VOID) os << '.' << ir::name(ins->type);
+
+      std::vector<std::string> args;
+      if (ins->code == op::CMP) args.push_back(ir::name(ins->cc));
+      if (ins->code == op::CONST) args.push_back(ins->type == type::DOUBLE ? std::to_string(ins->d) : std::to_string(ins->i));
+      if (ins->code == op::SLOT || ins->code == op::PARAM) args.push_back(std::to_string(ins->i));
+      if (!ins->s.empty()) args.push_back(ins->s);
+      for (size_t k = 0; k < ins->operands.size(); k++) {
+        args.push_back("%" + std::to_string(ins->operands[k]->id));
+        if (ins->code == op::PHI) args.back() += " from b" + std::to_string(ins->targets[k]->id);
+      }
+      if (ins->code != op::PHI) {
+        for (block *target : ins->targets) {
+          args.push_back("b" + std::to_string(target->id));
+        }
+      }
+      for (size_t k = 0; k < args.size(); k++) {
+        os << (k ? ", " : " ") << args[k];
+      }
+      os << '\n';
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+std::string til::ir::module::label() {
+  return "_L" + std::to_string(_space) + "_" + std::to_string(++_labels);
+}
+
+void til::ir::module::print(std::ostream &os) const {
+  for (auto &[label, characters] : _strings) {
+    os << "string " << label << " \"" << characters << "\"\n";
+  }
+  for (auto &g : _globals) {
+    os << "global " << g.name << (g.exported ? " exported" : "");
+    if (g.data.empty()) os << " [" << g.size << " bytes]";
+    for (auto &d : g.data) {
+      if (d.kind == datum::INT) os << ' ' << d.i;
+      else if (d.kind == datum::DOUBLE) os << ' ' << d.d;
+      else os << ' ' << d.s;
+    }
+    os << '\n';
+  }
+  for (auto &f : _functions) {
+    f->print(os);
+  }
+}
@@ -0,0 +1,253 @@
+#ifndef __TIL_IR_IR_H__
+#define __TIL_IR_IR_H__
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace til::ir {
+
+  /**
+   * Intermediate representation: functions made of basic blocks of
+   * instructions in SSA form (each instruction is the value it computes).
+   * Local variables start out in memory (SLOT, LOAD, STORE); control flow is
+   * explicit (each block ends in JUMP, BRANCH or RETURN), and values merge
+   * at the start of blocks (PHI).
+   */
+
+  /** Types of values: pointers also stand for strings; functions are addresses of code. */
+  enum class type { VOID, INT, DOUBLE, POINTER, FUNCTION };
+
+  const char *name(type t);
+
+  enum class op {
+    CONST,    // integer (i) or double (d) constant
+    ADDRESS,  // address of a global variable, string or function (s)
+    SLOT,     // address of a local variable of i bytes
+    PARAM,    // value of argument i
+    LOAD,     // value at address [0]
+    STORE,    // store [1] at address [0]
+    ALLOC,    // pointer to [0] bytes allocated in the current frame
+    ADD, SUB, MUL, DIV, MOD, NEG, AND, OR, // of the instruction's type (ADD and SUB also of pointers)
+    CMP,      // 1 if [0] cc [1] (two ints, pointers or doubles), else 0
+    I2D,      // int [0] as a double
+    CALL,     // call function s (or [0], when s is empty) with the other operands as arguments
+    PHI,      // [k] when control comes from targets[k]
+    JUMP,     // to targets[0]
+    BRANCH,   // to targets[0] if [0] is not zero, else to targets[1]
+    RETURN,   // [0], if the function returns a value
+  };
+
+  const char *name(op o);
+
+  /** Comparisons. */
+  enum class cond { EQ, NE, LT, LE, GT, GE };
+
+  const char *name(cond c);
+
+  /** The comparison that holds when `c' does not. */
+  cond negate(cond c);
+
+  struct block;
+
+  struct instruction {
+    op code;
+    ir::type type;
+    std::vector<instruction*> operands;
+    std::vector<block*> targets; // JUMP and BRANCH destinations, PHI predecessors
+    int i = 0;
+    double d = 0;
+    std::string s;
+    ir::cond cc = ir::cond::EQ;
+    int id = 0;                  // for printing (%<id>)
+    block *parent = nullptr;
+
+    bool terminator() const {
+      return code == op::JUMP || code == op::BRANCH || code == op::RETURN;
+    }
+
+    /** Whether the instruction does anything besides computing its value. */
+    bool effects() const {
+      return code == op::STORE || code == op::CALL || code == op::ALLOC || terminator();
+    }
+
+    /** Whether the value depends on memory. */
+    bool reads() const {
+      return code == op::LOAD || code == op::CALL;
+    }
+  };
+
+  struct block {
+    int id = 0;                  // for printing (b<id>)
+    std::vector<instruction*> code;
+
+    instruction *terminator() const {
+      return !code.empty() && code.back()->terminator() ? code.back() : nullptr;
+    }
+    std::vector<block*> successors() const;
+  };
+
+  /** Thrown for constructs a stage cannot handle: the caller falls back to the postfix writer. */
+  struct unsupported {
+    std::string what;
+  };
+
+  class function {
+    std::string _name;           // label of the code
+    bool _exported;
+    std::vector<type> _params;
+    type _result;
+    std::vector<std::unique_ptr<instruction>> _values;
+    std::vector<std::unique_ptr<block>> _blocks; // in layout order; the first is the entry
+    int _ids = 0;
+
+  public:
+    function(const std::string &name, bool exported, const std::vector<type> &params, type result) :
+        _name(name), _exported(exported), _params(params), _result(result) {
+    }
+
+  public:
+    const std::string &name() const {
+      return _name;
+    }
+    bool exported() const {
+      return _exported;
+    }
+    const std::vector<type> &params() const {
+      return _params;
+    }
+    type result() const {
+      return _result;
+    }
+
+    block *entry() const {
+      return _blocks.front().get();
+    }
+    const std::vector<std::unique_ptr<block>> &blocks() const {
+      return _blocks;
+    }
+
+    /** New empty block, at the end of the layout. */
+    block *add_block();
+
+    /** New block, placed in the layout right after `after'. */
+    block *add_block_after(block *after);
+
+    /** Move a block to the end of the layout. */
+    void place(block *b);
+
+    /** Drop the blocks for which `dead' holds (their instructions must not be used elsewhere). */
+    template<typename predicate>
+    void remove_blocks(predicate dead) {
+      std::vector<std::unique_ptr<block>> kept;
+      for (auto &b : _blocks) {
+        if (!dead(b.get())) kept.push_back(std::move(b));
+      }
+      _blocks = std::move(kept);
+    }
+
+    /** New instruction, not yet in any block. */
+    instruction *make(op code, type t, const std::vector<instruction*> &operands = {});
+
+    /** Append a new instruction to a block. */
+    instruction *append(block *b, op code, type t, const std::vector<instruction*> &operands = {});
+
+    /** Predecessors of each block, in layout order. */
+    std::unordered_map<const block*, std::vector<block*>> predecessors() const;
+
+    /** Number of uses of each instruction. */
+    std::unordered_map<const instruction*, size_t> uses() const;
+
+    /** Replace every use of each key by its value. */
+    void replace(const std::unordered_map<instruction*, instruction*> &by);
+
+    /** Renumber blocks and values in layout order. */
+    void renumber();
+
+    /** Check the structure of the code; throws a description of the first problem found. */
+    void verify() const;
+
+    void print(std::ostream &os) const;
+  };
+
+  /** Initial contents of global variables. */
+  struct datum {
+    enum kind_type { INT, DOUBLE, ADDRESS } kind;
+    int i = 0;
+    double d = 0;
+    std::string s;               // label of the address
+  };
+
+  struct global {
+    std::string name;
+    bool exported = false;
+    size_t size = 0;             // bytes, when not initialized
+    std::vector<datum> data;
+  };
+
+  /**
+   * The IR of one compilation unit (a top-level declaration or the program):
+   * its functions, global variables and string literals, and the external
+   * functions it declares (true) or defines (false). Labels are generated
+   * in the unit's namespace, as by the postfix writer (_L<space>_<n>).
+   */
+  class module {
+    int _space;
+    int _labels = 0;
+    std::vector<std::unique_ptr<function>> _functions;
+    std::vector<global> _globals;
+    std::vector<std::pair<std::string, std::string>> _strings; // label, characters
+    std::map<std::string, bool> _externals;
+
+  public:
+    explicit module(int space = 0) :
+        _space(space) {
+    }
+
+  public:
+    /** A new label of the unit's namespace. */
+    std::string label();
+
+    function *add_function(const std::string &name, bool exported, const std::vector<type> &params, type result) {
+      return _functions.emplace_back(std::make_unique<function>(name, exported, params, result)).get();
+    }
+    const std::vector<std::unique_ptr<function>> &functions() const {
+      return _functions;
+    }
+
+    void add_global(global &&g) {
+      _globals.push_back(std::move(g));
+    }
+    const std::vector<global> &globals() const {
+      return _globals;
+    }
+
+    /** @return the label of a new string literal */
+    std::string add_string(const std::string &characters) {
+      return _strings.emplace_back(label(), characters).first;
+    }
+    const std::vector<std::pair<std::string, std::string>> &strings() const {
+      return _strings;
+    }
+
+    void external(const std::string &name, bool needed) {
+      _externals[name] = needed;
+    }
+    const std::map<std::string, bool> &externals() const {
+      return _externals;
+    }
+
+    void print(std::ostream &os) const;
+  };
+
+  /** Bytes taken by a value of the type in the 32-bit postfix machine. */
+  inline size_t size(type t) {
+    return t == type::DOUBLE ? 8 : t == type::VOID ? 0 : 4;
+  }
+
+} // til::ir
+
+#endif
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <unordered_set>
+#include "ir/passes.h"
+
+//---------------------------------------------------------------------------
+
+til::ir::pass_manager til::ir::pass_manager::standard(bool verify) {
+  pass_manager passes(verify);
+  passes.add(std::make_unique<simplify_cfg>());
+  passes.add(std::make_unique<mem2reg>());
+  passes.add(std::make_unique<dead_code>());
+  passes.add(std::make_unique<simplify_cfg>());
+  return passes;
+}
+
+void til::ir::pass_manager::run(module &m) {
+  for (auto &f : m.functions()) {
+    if (_verify) f->verify();
+    for (auto &p : _passes) {
+      if (!p->run(*f)) continue;
+      _changed[p->name()]++;
+      if (_verify) {
+        try {
+          f->verify();
+        }
+        catch (const std::string &problem) {
+          throw std::string("after ") + p->name() + ": " + problem;
+        }
+      }
+    }
+    f->renumber();
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::remove_incoming(block *to, const block *from) {
+  for (instruction *ins : to->code) {
+    if (ins->code != op::PHI) break;
+    for (size_t k = ins->targets.size(); k-- > 0; ) {
+      if (ins->targets[k] == from) {
+        ins->targets.erase(ins->targets.begin() + k);
+        ins->operands.erase(ins->operands.begin() + k);
+      }
+    }
+  }
+}
+
+bool til::ir::remove_single_phis(function &f) {
+  std::unordered_map<instruction*, instruction*> single;
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (ins->code == op::PHI && ins->operands.size() == 1) single[ins] = ins->operands[0];
+    }
+  }
+  if (single.empty()) return false;
+
+  f.replace(single);
+  for (auto &b : f.blocks()) {
+    auto end = std::remove_if(b->code.begin(), b->code.end(), [&single](instruction *ins) { return single.count(ins) > 0; });
+    b->code.erase(end, b->code.end());
+  }
+  return true;
+}
+
+// Cooper, Harvey and Kennedy's iteration over the blocks in reverse postorder
+std::unordered_map<const til::ir::block*, til::ir::block*> til::ir::dominators(const function &f) {
+  std::vector<block*> order; // postorder
+  std::unordered_map<const block*, size_t> number;
+  std::vector<std::pair<block*, size_t>> work{{f.entry(), 0}};
+  std::unordered_set<const block*> seen{f.entry()};
+  while (!work.empty()) {
+    auto &[b, next] = work.back();
+    auto successors = b->successors();
+    if (next < successors.size()) {
+      block *s = successors[next++];
+      if (seen.insert(s).second) work.push_back({s, 0});
+    } else {
+      number[b] = order.size();
+      order.push_back(b);
+      work.pop_back();
+    }
+  }
+
+  auto preds = f.predecessors();
+  std::unordered_map<const block*, block*> idom{{f.entry(), f.entry()}};
+  auto intersect = [&](block *a, block *b) {
+    while (a != b) {
+      while (number[a] < number[b]) a = idom[a];
+      while (number[b] < number[a]) b = idom[b];
+    }
+    return a;
+  };
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      block *b = *it;
+      if (b == f.entry()) continue;
+      block *dominator = nullptr;
+      for (block *p : preds[b]) {
+        if (idom.count(p) == 0) continue; // not processed yet, or unreachable
+        dominator = dominator == nullptr ? p : intersect(p, dominator);
+      }
+      if (dominator != nullptr && idom[b] != dominator) {
+        idom[b] = dominator;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+bool til::ir::split_critical_edges(function &f) {
+  auto preds = f.predecessors();
+  bool changed = false;
+
+  std::vector<block*> blocks;
+  for (auto &b : f.blocks()) blocks.push_back(b.get());
+
+  for (block *b : blocks) {
+    instruction *last = b->terminator();
+    if (last == nullptr || last->targets.size() < 2) continue;
+    for (block *&target : last->targets) {
+      if (preds[target].size() < 2 || target->code.empty() || target->code.front()->code != op::PHI) continue;
+
+      // the edge block jumps to the target, and takes the place of `b' in its PHIs
+      block *edge = f.add_block_after(b);
+      f.append(edge, op::JUMP, type::VOID)->targets.push_back(target);
+      for (instruction *ins : target->code) {
+        if (ins->code != op::PHI) break;
+        std::replace(ins->targets.begin(), ins->targets.end(), b, edge);
+      }
+      target = edge;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+//---------------------------------------------------------------------------
+
+bool til::ir::simplify_cfg::run(function &f) {
+  bool changed = false;
+  for (bool again = true; again; ) {
+    again = false;
+
+    // branches with a known outcome
+    for (auto &b : f.blocks()) {
+      instruction *last = b->terminator();
+      if (last == nullptr || last->code != op::BRANCH) continue;
+
+      block *taken = nullptr;
+      if (last->targets[0] == last->targets[1]) {
+        taken = last->targets[0];
+      } else if (last->operands[0]->code == op::CONST && last->operands[0]->type != type::DOUBLE) {
+        taken = last->targets[last->operands[0]->i != 0 ? 0 : 1];
+        remove_incoming(last->targets[last->operands[0]->i != 0 ? 1 : 0], b.get());
+      }
+      if (taken != nullptr) {
+        last->code = op::JUMP;
+        last->operands.clear();
+        last->targets = {taken};
+        again = true;
+      }
+    }
+
+    // unreachable blocks
+    std::unordered_set<const block*> reached;
+    std::vector<block*> work{f.entry()};
+    while (!work.empty()) {
+      block *b = work.back();
+      work.pop_back();
+      if (!reached.insert(b).second) continue;
+      for (block *s : b->successors()) work.push_back(s);
+    }
+    if (reached.size() < f.blocks().size()) {
+      for (auto &b : f.blocks()) {
+        if (reached.count(b.get()) > 0) continue;
+        for (block *s : b->successors()) {
+          if (reached.count(s) > 0) remove_incoming(s, b.get());
+        }
+      }
+      f.remove_blocks([&reached](const block *b) { return reached.count(b) == 0; });
+      again = true;
+    }
+
+    // a block that is the only successor of its only predecessor joins it
+    auto preds = f.predecessors();
+    std::unordered_set<const block*> merged;
+    for (auto &b : f.blocks()) {
+      if (merged.count(b.get()) > 0) continue;
+      instruction *last = b->terminator();
+      if (last == nullptr || last->code != op::JUMP) continue;
+      block *next = last->targets[0];
+      if (next == b.get() || next == f.entry() || preds[next].size() != 1 || merged.count(next) > 0) continue;
+
+      std::unordered_map<instruction*, instruction*> single;
+      b->code.pop_back();
+      for (instruction *ins : next->code) {
+        if (ins->code == op::PHI) {
+          single[ins] = ins->operands[0];
+        } else {
+          ins->parent = b.get();
+          b->code.push_back(ins);
+        }
+      }
+      next->code.clear();
+      f.replace(single);
+      for (block *s : b->successors()) {
+        for (instruction *ins : s->code) {
+          if (ins->code != op::PHI) break;
+          std::replace(ins->targets.begin(), ins->targets.end(), next, b.get());
+        }
+      }
+      merged.insert(next);
+      for (block *s : b->successors()) {
+        auto &list = preds[s];
+        std::replace(list.begin(), list.end(), next, b.get());
+      }
+    }
+    if (!merged.empty()) {
+      f.remove_blocks([&merged](const block *b) { return merged.count(b) > 0; });
+      again = true;
+    }
+
+    // jumps to empty blocks that just jump on (when the destination has no PHIs to update)
+    for (auto &b : f.blocks()) {
+      instruction *last = b->terminator();
+      if (last == nullptr) continue;
+      for (block *&target : last->targets) {
+        block *final = target;
+        for (int hops = 0; hops < 8 && final->code.size() == 1 && final->code[0]->code == op::JUMP; hops++) {
+          block *next = final->code[0]->targets[0];
+          if (next == final || (!next->code.empty() && next->code.front()->code == op::PHI)) break;
+          final = next;
+        }
+        if (final != target && (target->code.empty() || target->code.front()->code != op::PHI)) {
+          target = final;
+          again = true;
+        }
+      }
+    }
+
+    changed = changed || again;
+  }
+  return changed;
+}
+
+//---------------------------------------------------------------------------
+
+bool til::ir::mem2reg::run(function &f) {
+  // the uses of each slot decide whether it can be promoted, and to which type
+  std::unordered_map<instruction*, type> promoted;
+  std::unordered_set<instruction*> escaped;
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (ins->code == op::SLOT) promoted.emplace(ins, type::VOID);
+      for (size_t k = 0; k < ins->operands.size(); k++) {
+        instruction *slot = ins->operands[k];
+        if (slot->code != op::SLOT) continue;
+        type &accessed = promoted[slot];
+        if (k == 0 && (ins->code == op::LOAD || ins->code == op::STORE)) {
+          type t = ins->code == op::LOAD ? ins->type : ins->operands[1]->type;
+          if (size(t) == static_cast<size_t>(slot->i) && (accessed == type::VOID || accessed == t)) {
+            accessed = t;
+            continue;
+          }
+        }
+        escaped.insert(slot);
+      }
+    }
+  }
+  for (instruction *slot : escaped) {
+    promoted.erase(slot);
+  }
+  if (promoted.empty()) return false;
+
+  auto idom = dominators(f);
+  if (idom.size() < f.blocks().size()) return false; // unreachable blocks (see simplify_cfg)
+  auto preds = f.predecessors();
+  std::unordered_map<const block*, std::vector<block*>> children;
+  std::unordered_map<const block*, std::unordered_set<block*>> frontier;
+  for (auto &b : f.blocks()) {
+    if (b.get() != f.entry()) children[idom[b.get()]].push_back(b.get());
+    if (preds[b.get()].size() < 2) continue;
+    for (block *p : preds[b.get()]) {
+      for (block *runner = p; runner != idom[b.get()]; runner = idom[runner]) {
+        frontier[runner].insert(b.get());
+      }
+    }
+  }
+
+  // PHIs at the iterated dominance frontier of the stores
+  std::unordered_map<const instruction*, instruction*> variable; // PHI -> slot
+  for (auto &[slot, t] : promoted) {
+    std::vector<block*> work;
+    for (auto &b : f.blocks()) {
+      for (instruction *ins : b->code) {
+        if (ins->code == op::STORE && ins->operands[0] == slot) {
+          work.push_back(b.get());
+          break;
+        }
+      }
+    }
+    std::unordered_set<const block*> placed;
+    while (!work.empty()) {
+      block *b = work.back();
+      work.pop_back();
+      for (block *join : frontier[b]) {
+        if (!placed.insert(join).second) continue;
+        instruction *phi = f.make(op::PHI, t);
+        phi->parent = join;
+        join->code.insert(join->code.begin(), phi);
+        variable[phi] = slot;
+        work.push_back(join);
+      }
+    }
+  }
+
+  // renaming, down the dominator tree: the current value of each slot replaces its loads
+  std::unordered_map<instruction*, instruction*> by;
+  auto final = [&by](instruction *ins) {
+    for (auto it = by.find(ins); it != by.end(); it = by.find(ins)) ins = it->second;
+    return ins;
+  };
+  std::unordered_map<const instruction*, instruction*> zero; // value before any store
+  auto initial = [&](instruction *slot) {
+    auto it = zero.find(slot);
+    if (it != zero.end()) return it->second;
+    instruction *value = f.make(op::CONST, promoted[slot]);
+    value->parent = f.entry();
+    f.entry()->code.insert(f.entry()->code.begin(), value);
+    return zero[slot] = value;
+  };
+
+  std::unordered_set<const instruction*> removed;
+  std::unordered_map<const instruction*, std::vector<instruction*>> current;
+  std::vector<std::pair<block*, bool>> work{{f.entry(), false}};
+  std::vector<std::vector<const instruction*>> defined; // slots defined in each block on the path
+  while (!work.empty()) {
+    auto [b, done] = work.back();
+    work.pop_back();
+    if (done) {
+      for (const instruction *slot : defined.back()) current[slot].pop_back();
+      defined.pop_back();
+      continue;
+    }
+
+    defined.emplace_back();
+    auto define = [&](instruction *slot, instruction *value) {
+      current[slot].push_back(value);
+      defined.back().push_back(slot);
+    };
+    auto value = [&](instruction *slot) {
+      auto &stack = current[slot];
+      return stack.empty() ? initial(slot) : stack.back();
+    };
+
+    for (instruction *ins : b->code) {
+      if (ins->code == op::PHI && variable.count(ins) > 0) {
+        define(variable[ins], ins);
+      } else if (ins->code == op::LOAD && promoted.count(ins->operands[0]) > 0) {
+        by[ins] = value(ins->operands[0]);
+        removed.insert(ins);
+      } else if (ins->code == op::STORE && promoted.count(ins->operands[0]) > 0) {
+        define(ins->operands[0], final(ins->operands[1]));
+        removed.insert(ins);
+      }
+    }
+
+    std::vector<block*> successors = b->successors();
+    std::sort(successors.begin(), successors.end());
+    successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+    for (block *s : successors) {
+      for (instruction *ins : s->code) {
+        if (ins->code != op::PHI) break;
+        auto it = variable.find(ins);
+        if (it == variable.end()) continue;
+        ins->operands.push_back(value(it->second));
+        ins->targets.push_back(b);
+      }
+    }
+
+    work.push_back({b, true});
+    for (block *child : children[b]) {
+      work.push_back({child, false});
+    }
+  }
+  f.replace(by);
+
+  // PHIs that only other PHIs read are dropped
+  std::unordered_set<const instruction*> live;
+  std::vector<const instruction*> reached;
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (variable.count(ins) > 0 || removed.count(ins) > 0) continue;
+      for (instruction *operand : ins->operands) {
+        if (variable.count(operand) > 0 && live.insert(operand).second) reached.push_back(operand);
+      }
+    }
+  }
+  while (!reached.empty()) {
+    const instruction *phi = reached.back();
+    reached.pop_back();
+    for (instruction *operand : phi->operands) {
+      if (variable.count(operand) > 0 && live.insert(operand).second) reached.push_back(operand);
+    }
+  }
+
+  for (auto &b : f.blocks()) {
+    auto gone = [&](instruction *ins) {
+      return removed.count(ins) > 0 || promoted.count(ins) > 0 || (variable.count(ins) > 0 && live.count(ins) == 0);
+    };
+    b->code.erase(std::remove_if(b->code.begin(), b->code.end(), gone), b->code.end());
+  }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+
+bool til::ir::dead_code::run(function &f) {
+  bool changed = false;
+  for (bool again = true; again; ) {
+    again = false;
+    auto uses = f.uses();
+    for (auto &b : f.blocks()) {
+      auto dead = [&uses](const instruction *ins) { return !ins->effects() && uses.count(ins) == 0; };
+      auto end = std::remove_if(b->code.begin(), b->code.end(), dead);
+      if (end != b->code.end()) {
+        b->code.erase(end, b->code.end());
+        again = changed = true;
+      }
+    }
+  }
+  return changed;
+}
@@ -0,0 +1,118 @@
+#ifndef __TIL_IR_PASSES_H__
+#define __TIL_IR_PASSES_H__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ir/ir.h"
+
+namespace til::ir {
+
+  /** A transformation of the code of one function. */
+  class pass {
+  public:
+    virtual ~pass() {
+      // EMPTY
+    }
+
+    virtual const char *name() const = 0;
+
+    /** @return whether the function changed */
+    virtual bool run(function &f) = 0;
+  };
+
+  /**
+   * Run a sequence of passes over every function of a module, counting the
+   * functions each pass changed. With verification on, the code is checked
+   * before the first pass and after every pass that changed it.
+   */
+  class pass_manager {
+    std::vector<std::unique_ptr<pass>> _passes;
+    std::map<std::string, size_t> _changed;
+    bool _verify;
+
+  public:
+    explicit pass_manager(bool verify = false) :
+        _verify(verify) {
+    }
+
+  public:
+    pass_manager &add(std::unique_ptr<pass> p) {
+      _passes.push_back(std::move(p));
+      return *this;
+    }
+
+    /** The passes run on every unit. */
+    static pass_manager standard(bool verify = false);
+
+    void run(module &m);
+
+    /** Functions changed by each pass (by name). */
+    const std::map<std::string, size_t> &changed() const {
+      return _changed;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+
+  /**
+   * Control flow cleanup: branches on constants become jumps, unreachable
+   * blocks are removed, a block is merged into its only predecessor when it
+   * is that predecessor's only successor, and jumps to blocks that only
+   * jump elsewhere go straight to the final destination.
+   */
+  class simplify_cfg: public pass {
+  public:
+    const char *name() const {
+      return "simplify-cfg";
+    }
+    bool run(function &f);
+  };
+
+  /**
+   * Promote locals to SSA values: a SLOT that is only the address of LOADs
+   * and STOREs of one type (its address is never taken with "?", passed or
+   * stored) is replaced by the values stored in it, with PHIs where stores
+   * on different paths meet (pruned of PHIs nothing reads). Reads before
+   * any store are 0.
+   */
+  class mem2reg: public pass {
+  public:
+    const char *name() const {
+      return "mem2reg";
+    }
+    bool run(function &f);
+  };
+
+  /** Remove instructions whose values are not used and that have no other effect. */
+  class dead_code: public pass {
+  public:
+    const char *name() const {
+      return "dead-code";
+    }
+    bool run(function &f);
+  };
+
+  //---------------------------------------------------------------------------
+
+  /** Immediate dominator of each block reachable from the entry (the entry's is itself). */
+  std::unordered_map<const block*, block*> dominators(const function &f);
+
+  /** Remove the PHI entries for control coming from `from' into `to'. */
+  void remove_incoming(block *to, const block *from);
+
+  /** Replace the PHIs that have a single entry by that entry. @return whether there were such PHIs */
+  bool remove_single_phis(function &f);
+
+  /**
+   * Put a new block on every edge from a block with several successors to a
+   * block with several predecessors and PHIs, so that the values for the
+   * PHIs may be set on the edge alone. @return whether there were such edges
+   */
+  bool split_critical_edges(function &f);
+
+} // til::ir
+
+#endif
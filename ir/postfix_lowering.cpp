@@ -0,0 +1,393 @@
+#include <algorithm>
+#include "ir/postfix_lowering.h"
+#include "ir/passes.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using namespace til::ir;
+
+  // pushed again at each use, never kept
+  bool rematerialized(const instruction *ins) {
+    return ins->code == op::CONST || ins->code == op::ADDRESS || ins->code == op::SLOT || ins->code == op::PARAM;
+  }
+
+  bool commutative(const instruction *ins) {
+    return ins->code == op::ADD || ins->code == op::MUL || ins->code == op::AND || ins->code == op::OR
+        || ins->code == op::CMP;
+  }
+
+  // the comparison that holds with the operands swapped
+  cond mirror(cond c) {
+    switch (c) {
+      case cond::LT: return cond::GT;
+      case cond::LE: return cond::GE;
+      case cond::GT: return cond::LT;
+      case cond::GE: return cond::LE;
+      default: return c;
+    }
+  }
+
+  // operands in the order they are pushed: a call's arguments right to left, then
+  // the address of the function (its first operand, when it has no name)
+  std::vector<instruction*> pushed(const instruction *ins) {
+    switch (ins->code) {
+      case op::PHI: return {};
+      case op::STORE: return {ins->operands[1], ins->operands[0]};
+      case op::CALL: return {ins->operands.rbegin(), ins->operands.rend()};
+      default: return ins->operands;
+    }
+  }
+
+  using jump = void (til::postfix_buffer::*)(const std::string &);
+
+  jump conditional(cond cc) {
+    switch (cc) {
+      case cond::EQ: return &til::postfix_buffer::JEQ;
+      case cond::NE: return &til::postfix_buffer::JNE;
+      case cond::LT: return &til::postfix_buffer::JLT;
+      case cond::LE: return &til::postfix_buffer::JLE;
+      case cond::GT: return &til::postfix_buffer::JGT;
+      case cond::GE: return &til::postfix_buffer::JGE;
+    }
+    return nullptr;
+  }
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+void til::ir::postfix_lowering::run() {
+  for (auto &[label, characters] : _module.strings()) {
+    _pf.RODATA();
+    _pf.ALIGN();
+    _pf.LABEL(label);
+    _pf.SSTRING(characters);
+  }
+
+  for (auto &g : _module.globals()) {
+    if (g.data.empty()) _pf.BSS();
+    else _pf.DATA();
+    _pf.ALIGN();
+    if (g.exported) {
+      _pf.GLOBAL(g.name, _pf.OBJ());
+    }
+    _pf.LABEL(g.name);
+    if (g.data.empty()) {
+      _pf.SALLOC(g.size);
+    }
+    for (auto &d : g.data) {
+      if (d.kind == datum::INT) _pf.SINT(d.i);
+      else if (d.kind == datum::DOUBLE) _pf.SDOUBLE(d.d);
+      else _pf.SADDR(d.s);
+    }
+  }
+
+  for (auto &f : _module.functions()) {
+    write(*f);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::postfix_lowering::write(function &f) {
+  // PHIs with a single entry are that entry; the others are set on edges of their own
+  remove_single_phis(f);
+  split_critical_edges(f);
+  f.renumber();
+
+  _offsets.clear();
+  _stacked.clear();
+  _kept.clear();
+  _fused.clear();
+  _labels.clear();
+  _params.clear();
+  _uses = f.uses();
+
+  for (auto &b : f.blocks()) {
+    stackify(b.get());
+  }
+  size_t bytes = layout(f);
+
+  auto &blocks = f.blocks();
+  for (auto &b : blocks) {
+    for (block *target : b->successors()) label(target);
+  }
+
+  _pf.TEXT(f.name());
+  _pf.ALIGN();
+  if (f.exported()) {
+    _pf.GLOBAL(f.name(), _pf.FUNC());
+  }
+  _pf.LABEL(f.name());
+  _pf.ENTER(bytes);
+  _frames++;
+  _bytes += bytes;
+
+  for (size_t k = 0; k < blocks.size(); k++) {
+    block *b = blocks[k].get();
+    auto it = _labels.find(b);
+    if (it != _labels.end()) {
+      _pf.ALIGN();
+      _pf.LABEL(it->second);
+    }
+    const block *next = k + 1 < blocks.size() ? blocks[k + 1].get() : nullptr;
+    for (instruction *ins : b->code) {
+      emit(ins, next);
+    }
+  }
+}
+
+// frame offsets: arguments above the frame pointer, locals and temporaries below it
+size_t til::ir::postfix_lowering::layout(function &f) {
+  int offset = 8; // frame pointer and return address
+  for (type t : f.params()) {
+    _params.push_back(offset);
+    offset += static_cast<int>(size(t));
+  }
+
+  int low = 0;
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (ins->code == op::SLOT) {
+        low -= ins->i;
+        _offsets[ins] = low;
+      } else if (ins->type != type::VOID && !rematerialized(ins) && _uses[ins] > 0 && _kept.count(ins) == 0) {
+        low -= static_cast<int>(size(ins->type));
+        _offsets[ins] = low;
+      }
+    }
+  }
+  return -low;
+}
+
+// Decide which values stay on the stack. The block is simulated with a stack of the
+// values that could stay there: an instruction takes the longest prefix of what it
+// pushes from the top; values in the way, or out of order, go to temporaries instead
+// (a value that never was on the stack changes nothing for the instructions above it).
+void til::ir::postfix_lowering::stackify(block *b) {
+  std::unordered_set<const instruction*> used;
+  for (instruction *ins : b->code) {
+    if (ins->code != op::PHI) used.insert(ins->operands.begin(), ins->operands.end());
+  }
+
+  std::vector<const instruction*> stack;
+  for (instruction *ins : b->code) {
+    if (ins->code == op::PHI) continue;
+
+    // the operands of a commutative operation are swapped when that leaves the second one on the stack
+    if (commutative(ins) && ins->operands.size() == 2 && !stack.empty() && stack.back() == ins->operands[1]
+        && (stack.size() < 2 || stack[stack.size() - 2] != ins->operands[0])) {
+      std::swap(ins->operands[0], ins->operands[1]);
+      ins->cc = mirror(ins->cc);
+    }
+
+    auto order = pushed(ins);
+    auto operand = [&order](const instruction *v) { return std::find(order.begin(), order.end(), v) != order.end(); };
+
+    if (std::any_of(stack.begin(), stack.end(), operand)) {
+      while (!operand(stack.back())) stack.pop_back();
+    }
+    size_t k = std::min(order.size(), stack.size());
+    for (; k > 0; k--) {
+      if (std::equal(order.begin(), order.begin() + k, stack.end() - k)) break;
+    }
+    stack.resize(stack.size() - k);
+    _stacked[ins] = k;
+    _kept.insert(order.begin(), order.begin() + k);
+    if (ins->code == op::BRANCH && k == 1 && order[0]->code == op::CMP) {
+      _fused.insert(order[0]);
+    }
+
+    // ALLOC moves the stack pointer: nothing may be left under the memory it takes
+    if (ins->code == op::ALLOC) stack.clear();
+    else stack.erase(std::remove_if(stack.begin(), stack.end(), operand), stack.end());
+
+    if (ins->type != type::VOID && !rematerialized(ins) && _uses[ins] == 1 && used.count(ins) > 0) {
+      stack.push_back(ins);
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::postfix_lowering::push(const instruction *value) {
+  switch (value->code) {
+    case op::CONST:
+      if (value->type == type::DOUBLE) _pf.DOUBLE(value->d);
+      else _pf.INT(value->i);
+      return;
+    case op::ADDRESS:
+      _pf.ADDR(value->s);
+      return;
+    case op::SLOT:
+      _pf.LOCAL(_offsets.at(value));
+      return;
+    case op::PARAM:
+      _pf.LOCAL(_params.at(value->i));
+      break;
+    default:
+      _pf.LOCAL(_offsets.at(value));
+      break;
+  }
+  if (value->type == type::DOUBLE) _pf.LDDOUBLE();
+  else _pf.LDINT();
+}
+
+void til::ir::postfix_lowering::store(const instruction *value) {
+  _pf.LOCAL(_offsets.at(value));
+  if (value->type == type::DOUBLE) _pf.STDOUBLE();
+  else _pf.STINT();
+}
+
+// PHI entries for the edge: all values are pushed before any is stored (a parallel copy)
+void til::ir::postfix_lowering::copies(const block *from, const block *to) {
+  std::vector<const instruction*> phis;
+  for (instruction *ins : to->code) {
+    if (ins->code != op::PHI) break;
+    if (_offsets.count(ins) == 0) continue; // not used
+    auto k = std::find(ins->targets.begin(), ins->targets.end(), from) - ins->targets.begin();
+    push(ins->operands[k]);
+    phis.push_back(ins);
+  }
+  for (auto it = phis.rbegin(); it != phis.rend(); ++it) {
+    store(*it);
+  }
+}
+
+const std::string &til::ir::postfix_lowering::label(const block *b) {
+  auto it = _labels.find(b);
+  if (it == _labels.end()) {
+    it = _labels.emplace(b, _module.label()).first;
+  }
+  return it->second;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::postfix_lowering::emit(instruction *ins, const block *next) {
+  if (ins->code == op::PHI || rematerialized(ins)) return;
+
+  auto order = pushed(ins);
+  for (size_t k = _stacked[ins]; k < order.size(); k++) {
+    push(order[k]);
+  }
+
+  bool real = ins->type == type::DOUBLE;
+  switch (ins->code) {
+    case op::LOAD:
+      if (real) _pf.LDDOUBLE();
+      else _pf.LDINT();
+      break;
+    case op::STORE:
+      if (ins->operands[1]->type == type::DOUBLE) _pf.STDOUBLE();
+      else _pf.STINT();
+      break;
+    case op::ALLOC:
+      _pf.ALLOC();
+      _pf.SP();
+      break;
+    case op::ADD:
+      if (real) _pf.DADD();
+      else _pf.ADD();
+      break;
+    case op::SUB:
+      if (real) _pf.DSUB();
+      else _pf.SUB();
+      break;
+    case op::MUL:
+      if (real) _pf.DMUL();
+      else _pf.MUL();
+      break;
+    case op::DIV:
+      if (real) _pf.DDIV();
+      else _pf.DIV();
+      break;
+    case op::MOD:
+      _pf.MOD();
+      break;
+    case op::NEG:
+      if (real) _pf.DNEG();
+      else _pf.NEG();
+      break;
+    case op::AND:
+      _pf.AND();
+      break;
+    case op::OR:
+      _pf.OR();
+      break;
+    case op::I2D:
+      _pf.I2D();
+      break;
+    case op::CMP:
+      // doubles are compared by DCMP, whose result is then compared with 0
+      if (ins->operands[0]->type == type::DOUBLE) {
+        _pf.DCMP();
+        _pf.INT(0);
+      }
+      if (_fused.count(ins) > 0) return; // the branch compares
+      switch (ins->cc) {
+        case cond::EQ: _pf.EQ(); break;
+        case cond::NE: _pf.NE(); break;
+        case cond::LT: _pf.LT(); break;
+        case cond::LE: _pf.LE(); break;
+        case cond::GT: _pf.GT(); break;
+        case cond::GE: _pf.GE(); break;
+      }
+      break;
+    case op::CALL: {
+      if (ins->s.empty()) _pf.BRANCH();
+      else _pf.CALL(ins->s);
+      int bytes = 0;
+      for (size_t k = ins->s.empty() ? 1 : 0; k < ins->operands.size(); k++) {
+        bytes += size(ins->operands[k]->type);
+      }
+      if (bytes > 0) {
+        _pf.TRASH(bytes);
+      }
+      if (ins->type == type::VOID || _uses[ins] == 0) return;
+      if (real) _pf.LDFVAL64();
+      else _pf.LDFVAL32();
+      break;
+    }
+    case op::JUMP:
+      copies(ins->parent, ins->targets[0]);
+      if (ins->targets[0] != next) _pf.JMP(label(ins->targets[0]));
+      return;
+    case op::BRANCH: {
+      // a fused comparison left both operands (or DCMP's result and 0); any other value is tested against 0
+      const instruction *test = ins->operands[0];
+      bool compared = _fused.count(test) > 0;
+      auto when = [&](bool taken) -> jump {
+        if (compared) return conditional(taken ? test->cc : negate(test->cc));
+        return taken ? &til::postfix_buffer::JNZ : &til::postfix_buffer::JZ;
+      };
+      block *yes = ins->targets[0], *no = ins->targets[1];
+      if (no == next) {
+        (_pf.*when(true))(label(yes));
+      } else if (yes == next) {
+        (_pf.*when(false))(label(no));
+      } else {
+        (_pf.*when(true))(label(yes));
+        _pf.JMP(label(no));
+      }
+      return;
+    }
+    case op::RETURN:
+      if (!ins->operands.empty()) {
+        if (ins->operands[0]->type == type::DOUBLE) _pf.STFVAL64();
+        else _pf.STFVAL32();
+      }
+      _pf.LEAVE();
+      _pf.RET();
+      return;
+    default:
+      return;
+  }
+
+  // the value stays on the stack for its user, goes to its temporary, or is dropped
+  if (ins->type == type::VOID || _kept.count(ins) > 0) return;
+  if (_offsets.count(ins) > 0) store(ins);
+  else _pf.TRASH(size(ins->type));
+}
@@ -0,0 +1,68 @@
+#ifndef __TIL_IR_POSTFIX_LOWERING_H__
+#define __TIL_IR_POSTFIX_LOWERING_H__
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ir/ir.h"
+#include "targets/postfix_buffer.h"
+
+namespace til::ir {
+
+  /**
+   * Write a module as postfix code. SSA values go back to the stack: a
+   * value used once, by a later instruction of its block, stays on the
+   * stack when nothing else is in the way (the operands it leaves are a
+   * prefix of what its user pushes); constants, addresses and arguments
+   * are pushed again at each use; every other value is kept in a frame
+   * temporary. PHIs are temporaries set at the end of each predecessor
+   * (critical edges are split first). A comparison read only by the
+   * branch that follows it becomes a conditional jump, and jumps to the
+   * next block in the layout are left out.
+   */
+  class postfix_lowering {
+    module &_module;
+    til::postfix_buffer &_pf;
+    size_t _frames = 0;
+    size_t _bytes = 0;
+
+    // state of the function being written
+    std::unordered_map<const instruction*, int> _offsets;    // of locals and temporaries
+    std::unordered_map<const instruction*, size_t> _stacked; // operands each instruction finds on the stack
+    std::unordered_set<const instruction*> _kept;            // values left on the stack for their user
+    std::unordered_set<const instruction*> _fused;           // comparisons written as conditional jumps
+    std::unordered_map<const instruction*, size_t> _uses;
+    std::unordered_map<const block*, std::string> _labels;
+    std::vector<int> _params;                                // offsets of the arguments
+
+  public:
+    postfix_lowering(module &m, til::postfix_buffer &pf) :
+        _module(m), _pf(pf) {
+    }
+
+  public:
+    void run();
+
+    /** Stack frames written, and their bytes (locals and temporaries). */
+    size_t frames() const {
+      return _frames;
+    }
+    size_t bytes() const {
+      return _bytes;
+    }
+
+  private:
+    void write(function &f);
+    size_t layout(function &f);
+    void stackify(block *b);
+    void push(const instruction *value);
+    void store(const instruction *value);
+    void emit(instruction *ins, const block *next);
+    void copies(const block *from, const block *to);
+    const std::string &label(const block *b);
+  };
+
+} // til::ir
+
+#endif
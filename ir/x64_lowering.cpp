@@ -0,0 +1,817 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include "ir/x64_lowering.h"
+#include "ir/passes.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using namespace til::ir;
+
+  enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+  const char *const gpr64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                               "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+  const char *const gpr32[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                               "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+
+  const int arguments[] = {RDI, RSI, RDX, RCX, R8, R9};
+  const int callee_saved[] = {RBX, R12, R13, R14, R15};  // homes of integers and pointers
+  const int first_home_xmm = 8;                          // homes of doubles: xmm8-xmm15
+
+  bool floating(type t) {
+    return t == type::DOUBLE;
+  }
+
+  // constants and addresses are operands of their users
+  bool homed(const instruction *ins) {
+    return ins->type != type::VOID && ins->code != op::CONST && ins->code != op::ADDRESS && ins->code != op::SLOT;
+  }
+
+  std::string reg(int r, type t) {
+    return t == type::INT ? gpr32[r] : gpr64[r];
+  }
+
+  std::string xmm(int r) {
+    return "xmm" + std::to_string(r);
+  }
+
+  std::string frame(int offset, type t) {
+    std::string size = t == type::INT ? "dword" : "qword";
+    return size + " [rbp" + (offset < 0 ? "-" : "+") + std::to_string(std::abs(offset)) + "]";
+  }
+
+  std::string bits(double d) {
+    uint64_t u;
+    std::memcpy(&u, &d, sizeof u);
+    char text[24];
+    std::snprintf(text, sizeof text, "0x%016llx", static_cast<unsigned long long>(u));
+    return text;
+  }
+
+  // condition codes: signed for integers and pointers, unsigned (flags of ucomisd) for doubles
+  std::string suffix(cond cc, bool doubles) {
+    switch (cc) {
+      case cond::EQ: return "e";
+      case cond::NE: return "ne";
+      case cond::LT: return doubles ? "b" : "l";
+      case cond::LE: return doubles ? "be" : "le";
+      case cond::GT: return doubles ? "a" : "g";
+      case cond::GE: return doubles ? "ae" : "ge";
+    }
+    return "";
+  }
+
+  int round8(int bytes) {
+    return (std::max(bytes, 8) + 7) & ~7;
+  }
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+void til::ir::x64_lowering::write(module &m) {
+  _module = &m;
+  for (auto &[label, characters] : m.strings()) {
+    _os << "section .rodata\n" << label << ":\n\tdb ";
+    for (unsigned char c : characters) {
+      _os << static_cast<int>(c) << ", ";
+    }
+    _os << "0\n";
+  }
+
+  // every global takes 8 bytes at least, so that pointers fit
+  for (auto &g : m.globals()) {
+    _os << (g.data.empty() ? "section .bss\n" : "section .data\n") << "align 8\n";
+    if (g.exported) {
+      _os << "global " << g.name << ":data\n";
+    }
+    _os << g.name << ":\n";
+    if (g.data.empty()) {
+      _os << "\tresb " << round8(static_cast<int>(g.size)) << "\n";
+    }
+    for (auto &d : g.data) {
+      if (d.kind == datum::INT) line("dq " + std::to_string(d.i));
+      else if (d.kind == datum::DOUBLE) line("dq " + bits(d.d));
+      else line("dq " + d.s);
+    }
+  }
+
+  for (auto &f : m.functions()) {
+    write(*f);
+  }
+
+  // later modules override earlier ones: a definition cancels a previous forward declaration
+  for (auto &[name, needed] : m.externals()) {
+    _externals[name] = needed;
+  }
+  _module = nullptr;
+}
+
+void til::ir::x64_lowering::finish() {
+  for (auto &[name, needed] : _externals) {
+    if (needed) _os << "extern " << name << "\n";
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::x64_lowering::write(function &f) {
+  remove_single_phis(f);
+  split_critical_edges(f);
+  f.renumber();
+
+  _homes.clear();
+  _slots.clear();
+  _fused.clear();
+  _labels.clear();
+  _saved.clear();
+
+  // a comparison right before the branch that is its only use sets the flags for the jump
+  auto uses = f.uses();
+  for (auto &b : f.blocks()) {
+    instruction *last = b->terminator();
+    if (last && last->code == op::BRANCH && b->code.size() >= 2) {
+      instruction *test = b->code[b->code.size() - 2];
+      if (test == last->operands[0] && test->code == op::CMP && uses[test] == 1) _fused.insert(test);
+    }
+  }
+
+  std::vector<interval> live = intervals(f);
+  allocate(live);
+  int bytes = layout(f);
+
+  auto &blocks = f.blocks();
+  for (auto &b : blocks) {
+    for (block *target : b->successors()) label(target);
+  }
+
+  _os << "section .text\nalign 16\n";
+  if (f.exported()) {
+    _os << "global " << f.name() << ":function\n";
+  }
+  _os << f.name() << ":\n";
+  prologue(f, bytes);
+  _functions++;
+
+  for (size_t k = 0; k < blocks.size(); k++) {
+    block *b = blocks[k].get();
+    auto it = _labels.find(b);
+    if (it != _labels.end()) {
+      _os << it->second << ":\n";
+    }
+    const block *next = k + 1 < blocks.size() ? blocks[k + 1].get() : nullptr;
+    for (instruction *ins : b->code) {
+      emit(ins, next);
+    }
+  }
+}
+
+// Live intervals, over the instructions numbered in layout order from 1 (arguments are
+// defined at 0, by the prologue). A value is live from its definition to its last use,
+// and through every block it is live into or out of; PHIs, and their entries, are live
+// at the end of the predecessors, where they are copied.
+std::vector<til::ir::x64_lowering::interval> til::ir::x64_lowering::intervals(function &f) {
+  std::unordered_map<const block*, int> first, last;
+  std::unordered_map<const instruction*, int> position;
+  std::vector<int> calls;
+  int n = 1;
+  for (auto &b : f.blocks()) {
+    first[b.get()] = n;
+    for (instruction *ins : b->code) {
+      if (ins->code == op::CALL) calls.push_back(n);
+      position[ins] = n++;
+    }
+    last[b.get()] = n - 1;
+  }
+
+  auto value = [this](const instruction *ins) {
+    return homed(ins) && _fused.count(ins) == 0;
+  };
+
+  // liveness, iterated to a fixed point: PHIs are defined at the start of their blocks, and
+  // their entries used at the end of the predecessors
+  using values = std::unordered_set<instruction*>;
+  std::unordered_map<const block*, values> gen, kill, exits, in, out;
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (value(ins)) kill[b.get()].insert(ins);
+      for (size_t k = 0; k < ins->operands.size(); k++) {
+        instruction *o = ins->operands[k];
+        if (!value(o)) continue;
+        if (ins->code == op::PHI) exits[ins->targets[k]].insert(o);
+        else if (o->parent != b.get()) gen[b.get()].insert(o);
+      }
+    }
+  }
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (auto it = f.blocks().rbegin(); it != f.blocks().rend(); ++it) {
+      const block *b = it->get();
+      values &o = out[b], &i = in[b];
+      size_t before = o.size() + i.size();
+      o.insert(exits[b].begin(), exits[b].end());
+      for (block *s : b->successors()) {
+        o.insert(in[s].begin(), in[s].end());
+      }
+      i.insert(gen[b].begin(), gen[b].end());
+      for (instruction *v : o) {
+        if (kill[b].count(v) == 0) i.insert(v);
+      }
+      if (o.size() + i.size() != before) changed = true;
+    }
+  }
+
+  std::unordered_map<const instruction*, interval> ranges;
+  std::vector<instruction*> order;
+  auto extend = [&](instruction *v, int p) {
+    auto [it, fresh] = ranges.try_emplace(v, interval{v, p, p});
+    if (fresh) order.push_back(v);
+    it->second.start = std::min(it->second.start, p);
+    it->second.end = std::max(it->second.end, p);
+  };
+  for (auto &b : f.blocks()) {
+    for (instruction *v : in[b.get()]) extend(v, first[b.get()]);
+    for (instruction *v : out[b.get()]) extend(v, last[b.get()]);
+    for (instruction *ins : b->code) {
+      if (value(ins)) extend(ins, ins->code == op::PARAM ? 0 : position[ins]);
+      for (size_t k = 0; k < ins->operands.size(); k++) {
+        instruction *o = ins->operands[k];
+        if (ins->code == op::PHI) {
+          extend(ins, last[ins->targets[k]]);
+          if (value(o)) extend(o, last[ins->targets[k]]);
+        } else if (value(o)) {
+          // a fused comparison is written by the branch after it
+          extend(o, _fused.count(ins) > 0 ? position[ins] + 1 : position[ins]);
+        }
+      }
+    }
+  }
+
+  std::vector<interval> live;
+  for (instruction *v : order) {
+    interval i = ranges[v];
+    auto c = std::upper_bound(calls.begin(), calls.end(), i.start);
+    i.calls = c != calls.end() && *c < i.end;
+    live.push_back(i);
+  }
+  return live;
+}
+
+// Poletto and Sarkar's linear scan: intervals by increasing start, a register for each
+// while there are free ones; otherwise, of the current interval and those active in its
+// class, the one that ends last goes to the frame.
+void til::ir::x64_lowering::allocate(std::vector<interval> &live) {
+  std::stable_sort(live.begin(), live.end(), [](const interval &a, const interval &b) { return a.start < b.start; });
+
+  std::vector<int> gprs(std::rbegin(callee_saved), std::rend(callee_saved)); // free registers, taken from the back
+  std::vector<int> xmms;
+  for (int r = 15; r >= first_home_xmm; r--) xmms.push_back(r);
+  std::vector<interval*> active;
+  int spills = 0;
+
+  auto spill = [&](const interval &i) {
+    _homes[i.value] = {home::STACK, spills++};
+    _spilled++;
+  };
+
+  for (interval &i : live) {
+    bool doubles = floating(i.value->type);
+    for (auto it = active.begin(); it != active.end(); ) {
+      if ((*it)->end > i.start) {
+        ++it;
+        continue;
+      }
+      home h = _homes[(*it)->value];
+      (h.kind == home::XMM ? xmms : gprs).push_back(h.reg);
+      it = active.erase(it);
+    }
+
+    if (doubles && i.calls) {
+      spill(i); // every xmm register is clobbered by calls
+      continue;
+    }
+    std::vector<int> &free = doubles ? xmms : gprs;
+    home::kind_type kind = doubles ? home::XMM : home::GPR;
+    if (!free.empty()) {
+      _homes[i.value] = {kind, free.back()};
+      free.pop_back();
+      active.push_back(&i);
+      continue;
+    }
+
+    interval *longest = nullptr;
+    for (interval *a : active) {
+      if (_homes[a->value].kind == kind && (!longest || a->end > longest->end)) longest = a;
+    }
+    if (longest && longest->end > i.end) {
+      _homes[i.value] = _homes[longest->value];
+      spill(*longest);
+      std::replace(active.begin(), active.end(), longest, &i);
+    } else {
+      spill(i);
+    }
+  }
+
+  for (interval &i : live) {
+    home h = _homes[i.value];
+    if (h.kind == home::GPR && std::find(_saved.begin(), _saved.end(), h.reg) == _saved.end()) _saved.push_back(h.reg);
+    if (h.kind != home::STACK) _allocated++;
+  }
+  std::sort(_saved.begin(), _saved.end());
+}
+
+// frame offsets, below the saved registers: locals (8 bytes at least, for pointers), then spilled values
+int til::ir::x64_lowering::layout(function &f) {
+  int low = -8 * static_cast<int>(_saved.size());
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (ins->code == op::SLOT) {
+        low -= round8(ins->i);
+        _slots[ins] = low;
+      }
+    }
+  }
+  int spills = low;
+  for (auto &[value, h] : _homes) {
+    if (h.kind != home::STACK) continue;
+    h.reg = spills - 8 * (h.reg + 1);
+    low = std::min(low, h.reg);
+  }
+  // the stack stays aligned on 16 bytes at calls
+  return (-low + 15) / 16 * 16 - 8 * static_cast<int>(_saved.size());
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir::x64_lowering::prologue(function &f, int bytes) {
+  line("push rbp");
+  line("mov rbp, rsp");
+  for (int r : _saved) {
+    line(std::string("push ") + gpr64[r]);
+  }
+  if (bytes > 0) {
+    line("sub rsp, " + std::to_string(bytes));
+  }
+
+  // arguments in registers, or above the return address
+  std::vector<home> arrivals;
+  size_t ints = 0, doubles = 0;
+  int above = 16;
+  for (type t : f.params()) {
+    if (floating(t) && doubles < 8) arrivals.push_back({home::XMM, static_cast<int>(doubles++)});
+    else if (!floating(t) && ints < std::size(arguments)) arrivals.push_back({home::GPR, arguments[ints++]});
+    else {
+      arrivals.push_back({home::STACK, above});
+      above += 8;
+    }
+  }
+  for (auto &b : f.blocks()) {
+    for (instruction *ins : b->code) {
+      if (ins->code != op::PARAM || where(ins).kind == home::NONE) continue;
+      home from = arrivals[ins->i];
+      if (from.kind == home::STACK) {
+        if (floating(ins->type)) line("movsd xmm0, " + frame(from.reg, ins->type));
+        else line("mov " + reg(RAX, ins->type) + ", " + frame(from.reg, ins->type));
+        define(ins, floating(ins->type) ? 0 : RAX);
+      } else {
+        define(ins, from.reg);
+      }
+    }
+  }
+}
+
+void til::ir::x64_lowering::epilogue() {
+  if (_saved.empty()) {
+    line("leave");
+  } else {
+    line("lea rsp, [rbp-" + std::to_string(8 * _saved.size()) + "]");
+    for (auto it = _saved.rbegin(); it != _saved.rend(); ++it) {
+      line(std::string("pop ") + gpr64[*it]);
+    }
+    line("pop rbp");
+  }
+  line("ret");
+}
+
+//---------------------------------------------------------------------------
+
+til::ir::x64_lowering::home til::ir::x64_lowering::where(const instruction *value) const {
+  auto it = _homes.find(value);
+  return it == _homes.end() ? home{} : it->second;
+}
+
+// the value as an operand as it is: a register, a frame slot or an integer constant ("" for others)
+std::string til::ir::x64_lowering::operand(const instruction *value) const {
+  if (value->code == op::CONST && !floating(value->type)) return std::to_string(value->i);
+  home h = where(value);
+  switch (h.kind) {
+    case home::GPR: return reg(h.reg, value->type);
+    case home::XMM: return xmm(h.reg);
+    case home::STACK: return frame(h.reg, value->type);
+    default: return "";
+  }
+}
+
+// the value in a register: its home, or else the scratch register it is loaded into
+std::string til::ir::x64_lowering::use(const instruction *value, int scratch) {
+  home h = where(value);
+  if (h.kind == home::GPR) return reg(h.reg, value->type);
+  if (h.kind == home::XMM) return xmm(h.reg);
+  return load(value, scratch);
+}
+
+// the value in a given register (an xmm register, for doubles)
+std::string til::ir::x64_lowering::load(const instruction *value, int scratch) {
+  home h = where(value);
+  if (floating(value->type)) {
+    std::string x = xmm(scratch);
+    if (value->code == op::CONST) {
+      line("mov r11, " + bits(value->d));
+      line("movq " + x + ", r11");
+    } else if (h.kind == home::XMM) {
+      if (h.reg != scratch) line("movapd " + x + ", " + xmm(h.reg));
+    } else {
+      line("movsd " + x + ", " + frame(h.reg, value->type));
+    }
+    return x;
+  }
+
+  std::string r = reg(scratch, value->type);
+  if (value->code == op::CONST) {
+    line(value->i == 0 ? "xor " + std::string(gpr32[scratch]) + ", " + gpr32[scratch] : "mov " + r + ", " + std::to_string(value->i));
+  } else if (value->code == op::SLOT) {
+    line("lea " + r + ", [rbp" + std::to_string(_slots[value]) + "]");
+  } else if (value->code == op::ADDRESS) {
+    line("lea " + r + ", [rel " + value->s + "]");
+  } else if (h.kind != home::GPR || h.reg != scratch) {
+    line("mov " + r + ", " + operand(value));
+  }
+  return r;
+}
+
+// the value as an operand, loaded into the scratch register when it cannot be one
+std::string til::ir::x64_lowering::source(const instruction *value, int scratch) {
+  std::string o = operand(value);
+  return o.empty() ? load(value, scratch) : o;
+}
+
+// memory at an address (through rax, when it is not a variable), for an access of type t
+std::string til::ir::x64_lowering::memory(const instruction *address, type t) {
+  if (address->code == op::SLOT) return "[rbp" + std::to_string(_slots[address]) + "]";
+  if (address->code == op::ADDRESS) return "[rel " + address->s + "]";
+  if (!floating(t) && t != type::INT) {
+    throw unsupported{"pointer stored outside a variable"}; // in 4 bytes
+  }
+  std::string r = use(address, RAX);
+  return "[" + r + "]";
+}
+
+// the register to compute an instruction in: its home, unless an operand after the first is there
+int til::ir::x64_lowering::target(const instruction *ins, int scratch) const {
+  home h = where(ins);
+  if (h.kind != home::GPR && h.kind != home::XMM) return scratch;
+  for (size_t k = 1; k < ins->operands.size(); k++) {
+    home o = where(ins->operands[k]);
+    if (o.kind == h.kind && o.reg == h.reg) return scratch;
+  }
+  return h.reg;
+}
+
+// the value computed in a register goes to its home
+void til::ir::x64_lowering::define(const instruction *ins, int r) {
+  home h = where(ins);
+  bool doubles = floating(ins->type);
+  std::string from = doubles ? xmm(r) : reg(r, ins->type);
+  switch (h.kind) {
+    case home::GPR:
+      if (h.reg != r) line("mov " + reg(h.reg, ins->type) + ", " + from);
+      break;
+    case home::XMM:
+      if (h.reg != r) line("movapd " + xmm(h.reg) + ", " + from);
+      break;
+    case home::STACK:
+      line((doubles ? "movsd " : "mov ") + frame(h.reg, ins->type) + ", " + from);
+      break;
+    default:
+      break; // not used
+  }
+}
+
+void til::ir::x64_lowering::push(const instruction *value) {
+  home h = where(value);
+  if (value->code == op::CONST && floating(value->type)) {
+    line("mov r11, " + bits(value->d));
+    line("push r11");
+  } else if (value->code == op::CONST) {
+    line("push " + std::to_string(value->i));
+  } else if (h.kind == home::XMM) {
+    line("sub rsp, 8");
+    line("movsd [rsp], " + xmm(h.reg));
+  } else if (h.kind == home::GPR) {
+    line(std::string("push ") + gpr64[h.reg]);
+  } else if (h.kind == home::STACK) {
+    line("push " + frame(h.reg, type::POINTER));
+  } else {
+    load(value, RAX);
+    line("push rax");
+  }
+}
+
+void til::ir::x64_lowering::pop(const instruction *value) {
+  home h = where(value);
+  if (h.kind == home::XMM) {
+    line("movsd " + xmm(h.reg) + ", [rsp]");
+    line("add rsp, 8");
+  } else if (h.kind == home::GPR) {
+    line(std::string("pop ") + gpr64[h.reg]);
+  } else {
+    line("pop " + frame(h.reg, type::POINTER));
+  }
+}
+
+// set the PHIs of `to' with their entries from `from': moved one by one when no entry is
+// the home of another PHI, or else all pushed and then popped (a parallel copy)
+void til::ir::x64_lowering::copies(const block *from, const block *to) {
+  std::vector<std::pair<instruction*, instruction*>> moves; // PHI, entry
+  for (instruction *ins : to->code) {
+    if (ins->code != op::PHI || where(ins).kind == home::NONE) continue;
+    size_t k = std::find(ins->targets.begin(), ins->targets.end(), from) - ins->targets.begin();
+    home a = where(ins), b = where(ins->operands[k]);
+    if (a.kind != b.kind || a.reg != b.reg) moves.emplace_back(ins, ins->operands[k]);
+  }
+
+  bool overlap = false;
+  for (auto &[phi, entry] : moves) {
+    home e = where(entry);
+    for (auto &[other, unused] : moves) {
+      home o = where(other);
+      if (other != phi && e.kind != home::NONE && o.kind == e.kind && o.reg == e.reg) overlap = true;
+    }
+  }
+
+  if (!overlap) {
+    for (auto &[phi, entry] : moves) {
+      home h = where(phi);
+      if (h.kind != home::STACK) {
+        load(entry, h.reg);
+        continue;
+      }
+      bool doubles = floating(phi->type);
+      home e = where(entry);
+      int r = doubles ? 0 : RAX;
+      if (e.kind == (doubles ? home::XMM : home::GPR)) r = e.reg;
+      else load(entry, r);
+      define(phi, r);
+    }
+    return;
+  }
+  for (auto &[phi, entry] : moves) {
+    push(entry);
+  }
+  for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+    pop(it->first);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// set the flags for a comparison
+void til::ir::x64_lowering::compare(const instruction *cmp) {
+  const instruction *a = cmp->operands[0], *b = cmp->operands[1];
+  if (floating(a->type)) {
+    std::string x = use(a, 0);
+    line("ucomisd " + x + ", " + source(b, 1));
+  } else {
+    std::string r = use(a, RAX);
+    line("cmp " + r + ", " + source(b, RCX));
+  }
+}
+
+// SysV: integers and pointers in rdi, rsi, rdx, rcx, r8 and r9, doubles in xmm0-xmm7, the
+// others pushed right to left (no argument is in one of those registers: none is a home)
+void til::ir::x64_lowering::call(instruction *ins) {
+  auto args = ins->operands.begin() + (ins->s.empty() ? 1 : 0);
+  std::vector<std::pair<const instruction*, int>> registers;
+  std::vector<const instruction*> stacked;
+  size_t ints = 0, doubles = 0;
+  for (auto it = args; it != ins->operands.end(); ++it) {
+    const instruction *arg = *it;
+    if (floating(arg->type) && doubles < 8) registers.emplace_back(arg, static_cast<int>(doubles++));
+    else if (!floating(arg->type) && ints < std::size(arguments)) registers.emplace_back(arg, arguments[ints++]);
+    else stacked.push_back(arg);
+  }
+
+  int bytes = 8 * static_cast<int>(stacked.size());
+  if (bytes % 16 != 0) {
+    line("sub rsp, 8");
+    bytes += 8;
+  }
+  for (auto it = stacked.rbegin(); it != stacked.rend(); ++it) {
+    push(*it);
+  }
+  for (auto &[arg, r] : registers) {
+    load(arg, r);
+  }
+  if (ins->s.empty()) {
+    load(ins->operands[0], R11);
+    line("call r11");
+  } else {
+    line("call " + ins->s);
+  }
+  if (bytes > 0) {
+    line("add rsp, " + std::to_string(bytes));
+  }
+  if (ins->type != type::VOID) {
+    define(ins, floating(ins->type) ? 0 : RAX);
+  }
+}
+
+void til::ir::x64_lowering::emit(instruction *ins, const block *next) {
+  auto &operands = ins->operands;
+  bool doubles = floating(ins->type);
+  switch (ins->code) {
+    case op::CONST:
+    case op::ADDRESS:
+    case op::SLOT:
+    case op::PARAM: // set by the prologue
+    case op::PHI:   // set by the predecessors
+      return;
+
+    case op::LOAD: {
+      std::string m = memory(operands[0], ins->type);
+      int r = target(ins, doubles ? 0 : RAX);
+      if (doubles) line("movsd " + xmm(r) + ", " + m);
+      else line("mov " + reg(r, ins->type) + ", " + m);
+      define(ins, r);
+      return;
+    }
+
+    case op::STORE: {
+      const instruction *v = operands[1];
+      std::string m = memory(operands[0], v->type);
+      if (floating(v->type)) line("movsd " + m + ", " + use(v, 0));
+      else if (v->code == op::CONST) line("mov " + std::string(v->type == type::INT ? "dword " : "qword ") + m + ", " + std::to_string(v->i));
+      else line("mov " + m + ", " + use(v, RCX));
+      return;
+    }
+
+    case op::ALLOC:
+      load(operands[0], RAX);
+      line("movsxd rax, eax");
+      line("add rax, 15");
+      line("and rax, -16");
+      line("sub rsp, rax");
+      line("mov rax, rsp");
+      define(ins, RAX);
+      return;
+
+    case op::ADD:
+    case op::SUB:
+    case op::MUL:
+    case op::AND:
+    case op::OR: {
+      static const std::map<op, std::string> integer = {{op::ADD, "add"}, {op::SUB, "sub"}, {op::MUL, "imul"},
+                                                        {op::AND, "and"}, {op::OR, "or"}};
+      static const std::map<op, std::string> floating_point = {{op::ADD, "addsd"}, {op::SUB, "subsd"},
+                                                               {op::MUL, "mulsd"}};
+      const instruction *a = operands[0], *b = operands[1];
+      // computed in its home, unless the second operand is there (and the operands cannot be swapped)
+      home h = where(ins), hb = where(b);
+      if (ins->code != op::SUB && ins->type != type::POINTER && hb.kind == h.kind && hb.reg == h.reg) std::swap(a, b);
+      hb = where(b);
+      int r = (h.kind == home::GPR || h.kind == home::XMM) && (hb.kind != h.kind || hb.reg != h.reg) ? h.reg : doubles ? 0 : RAX;
+      if (doubles) {
+        std::string x = load(a, r);
+        line(floating_point.at(ins->code) + " " + x + ", " + source(b, 1));
+      } else if (ins->type == type::POINTER) {
+        // the offset, an int, is sign-extended
+        const instruction *p = a->type == type::INT ? b : a, *n = a->type == type::INT ? a : b;
+        std::string offset = operand(n);
+        if (n->code != op::CONST) {
+          line("movsxd rcx, " + source(n, RCX));
+          offset = "rcx";
+        }
+        std::string x = load(p, r);
+        line(integer.at(ins->code) + " " + x + ", " + offset);
+      } else if (a->type != type::INT) {
+        // difference of pointers, in bytes
+        std::string x = gpr64[r];
+        load(a, r);
+        line("sub " + x + ", " + source(b, RCX));
+      } else if (ins->code == op::MUL && b->code == op::CONST) {
+        std::string x = load(a, r);
+        line("imul " + x + ", " + x + ", " + std::to_string(b->i));
+      } else {
+        std::string x = load(a, r);
+        line(integer.at(ins->code) + " " + x + ", " + source(b, RCX));
+      }
+      define(ins, r);
+      return;
+    }
+
+    case op::DIV:
+    case op::MOD: {
+      if (doubles) {
+        int r = target(ins, 0);
+        std::string x = load(operands[0], r);
+        line("divsd " + x + ", " + source(operands[1], 1));
+        define(ins, r);
+        return;
+      }
+      load(operands[0], RAX);
+      line("cdq");
+      const instruction *b = operands[1];
+      line("idiv " + (b->code == op::CONST ? load(b, RCX) : operand(b)));
+      define(ins, ins->code == op::DIV ? RAX : RDX);
+      return;
+    }
+
+    case op::NEG: {
+      int r = target(ins, doubles ? 0 : RAX);
+      std::string x = load(operands[0], r);
+      if (doubles) {
+        line("movq r11, " + x);
+        line("btc r11, 63");
+        line("movq " + x + ", r11");
+      } else {
+        line("neg " + x);
+      }
+      define(ins, r);
+      return;
+    }
+
+    case op::I2D: {
+      int r = target(ins, 0);
+      const instruction *a = operands[0];
+      line("cvtsi2sd " + xmm(r) + ", " + (a->code == op::CONST ? load(a, RCX) : operand(a)));
+      define(ins, r);
+      return;
+    }
+
+    case op::CMP:
+      if (_fused.count(ins) > 0) return; // the branch compares
+      compare(ins);
+      line("set" + suffix(ins->cc, floating(operands[0]->type)) + " al");
+      line("movzx eax, al");
+      define(ins, RAX);
+      return;
+
+    case op::CALL:
+      call(ins);
+      return;
+
+    case op::JUMP:
+      copies(ins->parent, ins->targets[0]);
+      if (ins->targets[0] != next) line("jmp " + label(ins->targets[0]));
+      return;
+
+    case op::BRANCH: {
+      const instruction *test = operands[0];
+      std::string yes, no;
+      if (_fused.count(test) > 0) {
+        compare(test);
+        bool doubles = floating(test->operands[0]->type);
+        yes = suffix(test->cc, doubles);
+        no = suffix(negate(test->cc), doubles);
+      } else if (test->code == op::CONST) {
+        block *to = ins->targets[test->i != 0 ? 0 : 1];
+        if (to != next) line("jmp " + label(to));
+        return;
+      } else {
+        std::string o = operand(test);
+        if (where(test).kind == home::STACK) line("cmp " + o + ", 0");
+        else line("test " + o + ", " + o);
+        yes = "ne";
+        no = "e";
+      }
+      if (ins->targets[0] == next) {
+        line("j" + no + " " + label(ins->targets[1]));
+      } else {
+        line("j" + yes + " " + label(ins->targets[0]));
+        if (ins->targets[1] != next) line("jmp " + label(ins->targets[1]));
+      }
+      return;
+    }
+
+    case op::RETURN:
+      if (!operands.empty()) {
+        load(operands[0], floating(operands[0]->type) ? 0 : RAX);
+      }
+      epilogue();
+      return;
+  }
+}
+
+void til::ir::x64_lowering::line(const std::string &text) {
+  _os << '\t' << text << '\n';
+}
+
+const std::string &til::ir::x64_lowering::label(const block *b) {
+  auto it = _labels.find(b);
+  if (it == _labels.end()) it = _labels.emplace(b, _module->label()).first;
+  return it->second;
+}
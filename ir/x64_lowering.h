@@ -0,0 +1,112 @@
+#ifndef __TIL_IR_X64_LOWERING_H__
+#define __TIL_IR_X64_LOWERING_H__
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ir/ir.h"
+
+namespace til::ir {
+
+  /**
+   * Write modules as x86-64 assembly (yasm/nasm, ELF64). Each value lives
+   * in a register or in a frame slot chosen by linear scan over the live
+   * intervals of the function (values numbered in layout order, one
+   * interval from first definition to last use): integers and pointers go
+   * to the callee-saved rbx and r12-r15, doubles to xmm8-xmm15 when no call
+   * happens while they are live; when none is free, the interval that ends
+   * last is spilled. Constants and addresses are not allocated: they are
+   * operands of the instructions that use them. The other registers are
+   * scratch, for instruction selection and calls, which follow the SysV
+   * convention (integers in rdi, rsi, rdx, rcx, r8 and r9, doubles in xmm0
+   * to xmm7, the rest on the stack; results in rax or xmm0), so the runtime
+   * functions are called directly. PHIs are copied at the end of each
+   * predecessor (critical edges are split first), through the stack when
+   * the copies overlap. A comparison read only by the branch that follows
+   * it becomes a conditional jump.
+   *
+   * Pointers take 8 bytes: local and global variables get room for them,
+   * but pointers stored anywhere else (arrays, allocated memory) would not
+   * fit the 4-byte layout of the language, and throw ir::unsupported.
+   */
+  class x64_lowering {
+    struct interval {
+      instruction *value;
+      int start, end;
+      bool calls = false;             // a call happens while the value is live
+    };
+
+    struct home {
+      enum kind_type { NONE, GPR, XMM, STACK } kind = NONE;
+      int reg = 0;                    // register number, or offset from rbp
+    };
+
+    std::ostream &_os;
+    std::map<std::string, bool> _externals;
+    size_t _functions = 0;
+    size_t _allocated = 0;
+    size_t _spilled = 0;
+
+    // state of the function being written
+    std::unordered_map<const instruction*, home> _homes;
+    std::unordered_map<const instruction*, int> _slots;   // offsets of locals
+    std::unordered_set<const instruction*> _fused;        // comparisons written as conditional jumps
+    std::unordered_map<const block*, std::string> _labels;
+    std::vector<int> _saved;                              // callee-saved registers in use
+    module *_module = nullptr;
+
+  public:
+    explicit x64_lowering(std::ostream &os) :
+        _os(os) {
+    }
+
+  public:
+    /** Write the data and code of a module (modules are written in source order). */
+    void write(module &m);
+
+    /** Declare the external functions used and not defined by the modules written. */
+    void finish();
+
+    /** Functions written, values kept in registers and values spilled to the frame. */
+    size_t functions() const {
+      return _functions;
+    }
+    size_t allocated() const {
+      return _allocated;
+    }
+    size_t spilled() const {
+      return _spilled;
+    }
+
+  private:
+    void write(function &f);
+    std::vector<interval> intervals(function &f);
+    void allocate(std::vector<interval> &live);
+    int layout(function &f);
+    void prologue(function &f, int bytes);
+    void epilogue();
+    void emit(instruction *ins, const block *next);
+    void compare(const instruction *cmp);
+    void call(instruction *ins);
+    void copies(const block *from, const block *to);
+
+    home where(const instruction *value) const;
+    std::string operand(const instruction *value) const;
+    std::string use(const instruction *value, int scratch);
+    std::string load(const instruction *value, int scratch);
+    std::string source(const instruction *value, int scratch);
+    std::string memory(const instruction *address, type t);
+    int target(const instruction *ins, int scratch) const;
+    void define(const instruction *ins, int reg);
+    void push(const instruction *value);
+    void pop(const instruction *value);
+    void line(const std::string &text);
+    const std::string &label(const block *b);
+  };
+
+} // til::ir
+
+#endif
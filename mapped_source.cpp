@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_source.h"
+
+til::mapped_source::~mapped_source() {
+  if (_data != nullptr) {
+    munmap(const_cast<char*>(_data), _size);
+  }
+}
+
+til::mapped_source &til::mapped_source::instance() {
+  static mapped_source _self;
+  return _self;
+}
+
+// whether a descriptor other than `except' refers to the file (the one the driver reads)
+static bool opened(const struct stat &file, int except) {
+  DIR *fds = opendir("/proc/self/fd");
+  if (fds == nullptr) return false;
+
+  bool found = false;
+  while (struct dirent *entry = readdir(fds)) {
+    int fd = std::atoi(entry->d_name);
+    struct stat info;
+    if (fd == except || fd == dirfd(fds) || entry->d_name[0] == '.') continue;
+    if (fstat(fd, &info) == 0 && info.st_dev == file.st_dev && info.st_ino == file.st_ino) {
+      found = true;
+      break;
+    }
+  }
+  closedir(fds);
+  return found;
+}
+
+bool til::mapped_source::map_input() {
+  if (_data != nullptr) return true;
+  if (_input.empty()) return false;
+
+  int input = open(_input.c_str(), O_RDONLY);
+  if (input < 0) return false;
+
+  struct stat info;
+  if (fstat(input, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0 || !opened(info, input)) {
+    close(input);
+    return false;
+  }
+
+  void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, input, 0);
+  close(input);
+  if (data == MAP_FAILED) return false;
+  madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+  _data = static_cast<const char*>(data);
+  _size = info.st_size;
+  _read = 0;
+  return true;
+}
+
+size_t til::mapped_source::read(char *buffer, size_t max_size) {
+  size_t n = std::min(max_size, _size - _read);
+  std::memcpy(buffer, _data + _read, n);
+  _read += n;
+  return n;
+}
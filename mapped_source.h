@@ -0,0 +1,65 @@
+#ifndef __TIL_MAPPED_SOURCE_H__
+#define __TIL_MAPPED_SOURCE_H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace til {
+
+  /**
+   * The source file, memory-mapped. The scanner reads its input from the
+   * mapping instead of the input stream, and tokens may refer to their text
+   * in place, as views of the mapping, which stays valid until the end of
+   * the compilation.
+   */
+  class mapped_source {
+    const char *_data = nullptr;
+    size_t _size = 0;
+    size_t _read = 0; // bytes already handed to the scanner
+    std::string _input; // name of the source file given to the driver
+
+  public:
+    mapped_source() = default;
+    mapped_source(const mapped_source&) = delete;
+    mapped_source &operator=(const mapped_source&) = delete;
+    ~mapped_source();
+
+    /** The source of the current compilation. */
+    static mapped_source &instance();
+
+    /** Name the file the driver reads the source from (empty: standard input). */
+    void input(const std::string &filename) {
+      _input = filename;
+    }
+
+    /**
+     * Map the file named with input(), provided the driver has it open: one
+     * of the process's other descriptors must refer to the same file.
+     * @return false if the source is not such a file or cannot be mapped
+     */
+    bool map_input();
+
+    bool mapped() const {
+      return _data != nullptr;
+    }
+
+    const char *data() const {
+      return _data;
+    }
+    size_t size() const {
+      return _size;
+    }
+
+    /** Copy the next bytes of the source to the scanner's buffer. */
+    size_t read(char *buffer, size_t max_size);
+
+    /** Text of the source at the given offset. */
+    std::string_view view(size_t offset, size_t length) const {
+      return std::string_view(_data + offset, length);
+    }
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "options.h"
+
+til::options::options() {
+  if (const char *jobs = std::getenv("TIL_JOBS")) {
+    char *end;
+    long n = std::strtol(jobs, &end, 10);
+    if (*jobs == '\0' || *end != '\0' || n < 0) {
+      std::cerr << "TIL_JOBS: \"" << jobs << "\" is not a number of jobs; using 1" << std::endl;
+    } else {
+      _jobs = n > 0 ? static_cast<unsigned>(n) : std::max(1u, std::thread::hardware_concurrency());
+    }
+  }
+  if (const char *cache = std::getenv("TIL_CACHE")) {
+    _cache = cache;
+  }
+  if (const char *times = std::getenv("TIL_TIMES")) {
+    _times = times;
+  }
+  if (const char *stats = std::getenv("TIL_STATS")) {
+    _stats = stats;
+  }
+  if (const char *mmap = std::getenv("TIL_MMAP")) {
+    _mmap = std::strtol(mmap, nullptr, 10) > 0;
+  }
+  if (const char *scanner = std::getenv("TIL_SCANNER")) {
+    _scanner = scanner;
+  }
+  if (const char *stream = std::getenv("TIL_STREAM")) {
+    _stream = std::strtol(stream, nullptr, 10) > 0;
+  }
+  if (const char *peephole = std::getenv("TIL_PEEPHOLE")) {
+    _peephole = std::strtol(peephole, nullptr, 10) != 0;
+  }
+  if (const char *ir = std::getenv("TIL_IR")) {
+    _ir = std::strtol(ir, nullptr, 10) > 0;
+  }
+  if (const char *sse2 = std::getenv("TIL_SSE2")) {
+    _sse2 = std::strtol(sse2, nullptr, 10) != 0;
+  }
+}
+
+const til::options &til::options::instance() {
+  static options _self;
+  return _self;
+}
@@ -0,0 +1,79 @@
+#ifndef __TIL_OPTIONS_H__
+#define __TIL_OPTIONS_H__
+
+#include <string>
+
+namespace til {
+
+  /**
+   * Compiler settings that are not part of the cdk command line. They are
+   * read once from the environment:
+   *   TIL_JOBS   number of code generation threads ("0" = one per core)
+   *   TIL_CACHE  directory of the compile cache (unset = no cache)
+   *   TIL_TIMES  file to which phase timings are appended (unset = no timing)
+   *   TIL_STATS  file for a Chrome trace of the compilation, with allocation
+   *              counts and peak memory (unset = no statistics)
+   *   TIL_MMAP   "1": scan the source file through a memory mapping (not
+   *              standard input, which is read as usual)
+   *   TIL_SCANNER "flex" (default), or the hand-written scanner over the
+   *              mapped source: "simd" (best instruction set), "avx2",
+   *              "sse2" or "scalar"
+   *   TIL_STREAM "1": compile each top-level declaration as soon as it is
+   *              parsed, and release its nodes (asm target only)
+   *   TIL_PEEPHOLE "0": do not run the peephole optimizer on the postfix code
+   *   TIL_IR     "1": generate code through the SSA intermediate representation
+   *   TIL_SSE2   "0": leave double arithmetic to the emitter's x87 code
+   *              instead of SSE2 (asm target)
+   */
+  class options {
+    unsigned _jobs = 1;
+    std::string _cache;
+    std::string _times;
+    std::string _stats;
+    bool _mmap = false;
+    std::string _scanner = "flex";
+    bool _stream = false;
+    bool _peephole = true;
+    bool _ir = false;
+    bool _sse2 = true;
+
+    options();
+
+  public:
+    static const options &instance();
+
+    unsigned jobs() const {
+      return _jobs;
+    }
+    const std::string &cache() const {
+      return _cache;
+    }
+    const std::string &times() const {
+      return _times;
+    }
+    const std::string &stats() const {
+      return _stats;
+    }
+    bool mmap() const {
+      return _mmap;
+    }
+    const std::string &scanner() const {
+      return _scanner;
+    }
+    bool stream() const {
+      return _stream;
+    }
+    bool peephole() const {
+      return _peephole;
+    }
+    bool ir() const {
+      return _ir;
+    }
+    bool sse2() const {
+      return _sse2;
+    }
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,47 @@
+#include "simd_kernels_impl.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+  // one byte at a time: the reference for the other instruction sets
+  struct scalar {
+    static constexpr int width = 1;
+    static char load(const char *p) { return *p; }
+    static bool eq(char v, char c) { return v == c; }
+    static bool between(char v, char lo, char hi) { return v >= lo && v <= hi; }
+    static bool either(bool a, bool b) { return a || b; }
+    static unsigned mask(bool v) { return v; }
+  };
+
+#ifdef __SSE2__
+  struct sse2 {
+    static constexpr int width = 16;
+    static __m128i load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static __m128i eq(__m128i v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+    // signed comparisons: bytes above 127 are negative and never in an ASCII range
+    static __m128i between(__m128i v, char lo, char hi) {
+      return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+    }
+    static __m128i either(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+    static unsigned mask(__m128i v) { return _mm_movemask_epi8(v); }
+  };
+#endif
+
+} // namespace
+
+const til::simd_kernels til::scalar_kernels = kernels<scalar>::table("scalar");
+
+#ifdef __SSE2__
+const til::simd_kernels til::sse2_kernels = kernels<sse2>::table("sse2");
+#else
+const til::simd_kernels til::sse2_kernels = kernels<scalar>::table("scalar");
+#endif
+
+const til::simd_kernels &til::best_kernels() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if (__builtin_cpu_supports("avx2")) return avx2_kernels;
+#endif
+  return sse2_kernels;
+}
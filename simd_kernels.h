@@ -0,0 +1,40 @@
+#ifndef __TIL_SIMD_KERNELS_H__
+#define __TIL_SIMD_KERNELS_H__
+
+namespace til {
+
+  /**
+   * Character classification loops of the SIMD scanner, one set per
+   * instruction set. Each returns the first position in [p, end) holding a
+   * character of the given class (or end); those that may skip newlines
+   * add the number of newlines skipped to `newlines'.
+   */
+  struct simd_kernels {
+    const char *name;
+
+    /** First character not in [ \t\n\r]. */
+    const char *(*skip_blanks)(const char *p, const char *end, int &newlines);
+
+    /** First character not in [A-Za-z0-9]. */
+    const char *(*skip_word)(const char *p, const char *end);
+
+    /** First '\n'. */
+    const char *(*find_newline)(const char *p, const char *end);
+
+    /** First '*' or '/' (inside comments). */
+    const char *(*find_comment_mark)(const char *p, const char *end, int &newlines);
+
+    /** First '"', '\\', '\n' or '\0' (inside string literals). */
+    const char *(*find_string_mark)(const char *p, const char *end);
+  };
+
+  extern const simd_kernels scalar_kernels;
+  extern const simd_kernels sse2_kernels; // same as scalar_kernels without SSE2
+  extern const simd_kernels avx2_kernels; // same as sse2_kernels without AVX2 support in the compiler
+
+  /** The best kernels the processor supports. */
+  const simd_kernels &best_kernels();
+
+} // til
+
+#endif
@@ -0,0 +1,36 @@
+// Compiled for AVX2 whatever the compiler flags: only used after checking
+// that the processor supports it (see best_kernels()).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#pragma GCC target("avx2")
+#include <immintrin.h>
+#define TIL_HAVE_AVX2
+#endif
+
+#include "simd_kernels_impl.h"
+
+#ifdef TIL_HAVE_AVX2
+
+namespace {
+
+  struct avx2 {
+    static constexpr int width = 32;
+    static __m256i load(const char *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static __m256i eq(__m256i v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); }
+    // signed comparisons: bytes above 127 are negative and never in an ASCII range
+    static __m256i between(__m256i v, char lo, char hi) {
+      return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                              _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+    }
+    static __m256i either(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+    static unsigned mask(__m256i v) { return _mm256_movemask_epi8(v); }
+  };
+
+} // namespace
+
+const til::simd_kernels til::avx2_kernels = kernels<avx2>::table("avx2");
+
+#else
+
+const til::simd_kernels til::avx2_kernels = til::sse2_kernels;
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef __TIL_SIMD_KERNELS_IMPL_H__
+#define __TIL_SIMD_KERNELS_IMPL_H__
+
+// Loops shared by every instruction set. A vector type V provides
+//   width                 bytes per block
+//   load(p)               unaligned load of a block
+//   eq(v, c), between(v, lo, hi), either(a, b)
+//   mask(v)               one bit per byte of a comparison result
+// Each file including this header compiles it for its own instruction set:
+// everything here has internal linkage, so versions never mix.
+
+#include "simd_kernels.h"
+
+namespace {
+
+  inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+  inline bool is_word(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+  }
+  inline bool is_string_mark(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\0';
+  }
+
+  inline int first_bit(unsigned mask) {
+    return __builtin_ctz(mask);
+  }
+  inline int bits(unsigned mask) {
+    return __builtin_popcount(mask);
+  }
+
+  template<typename V>
+  struct kernels {
+    static constexpr unsigned ALL = ~0u >> (32 - V::width); // one bit per byte of a block
+
+    static const char *skip_blanks(const char *p, const char *end, int &newlines) {
+      for (; end - p >= V::width; p += V::width) {
+        auto v = V::load(p);
+        unsigned nl = V::mask(V::eq(v, '\n'));
+        unsigned blank = nl | V::mask(V::either(V::either(V::eq(v, ' '), V::eq(v, '\t')), V::eq(v, '\r')));
+        unsigned other = ~blank & ALL;
+        if (other != 0) {
+          int n = first_bit(other);
+          newlines += bits(nl & ((1u << n) - 1));
+          return p + n;
+        }
+        newlines += bits(nl);
+      }
+      for (; p < end && is_blank(*p); p++) {
+        if (*p == '\n') newlines++;
+      }
+      return p;
+    }
+
+    static const char *skip_word(const char *p, const char *end) {
+      for (; end - p >= V::width; p += V::width) {
+        auto v = V::load(p);
+        unsigned word = V::mask(V::either(V::either(V::between(v, '0', '9'), V::between(v, 'A', 'Z')),
+                                          V::between(v, 'a', 'z')));
+        unsigned other = ~word & ALL;
+        if (other != 0) return p + first_bit(other);
+      }
+      while (p < end && is_word(*p)) p++;
+      return p;
+    }
+
+    static const char *find_newline(const char *p, const char *end) {
+      for (; end - p >= V::width; p += V::width) {
+        unsigned nl = V::mask(V::eq(V::load(p), '\n'));
+        if (nl != 0) return p + first_bit(nl);
+      }
+      while (p < end && *p != '\n') p++;
+      return p;
+    }
+
+    static const char *find_comment_mark(const char *p, const char *end, int &newlines) {
+      for (; end - p >= V::width; p += V::width) {
+        auto v = V::load(p);
+        unsigned nl = V::mask(V::eq(v, '\n'));
+        unsigned mark = V::mask(V::either(V::eq(v, '*'), V::eq(v, '/')));
+        if (mark != 0) {
+          int n = first_bit(mark);
+          newlines += bits(nl & ((1u << n) - 1));
+          return p + n;
+        }
+        newlines += bits(nl);
+      }
+      for (; p < end && *p != '*' && *p != '/'; p++) {
+        if (*p == '\n') newlines++;
+      }
+      return p;
+    }
+
+    static const char *find_string_mark(const char *p, const char *end) {
+      for (; end - p >= V::width; p += V::width) {
+        auto v = V::load(p);
+        unsigned mark = V::mask(V::either(V::either(V::eq(v, '"'), V::eq(v, '\\')),
+                                          V::either(V::eq(v, '\n'), V::eq(v, '\0'))));
+        if (mark != 0) return p + first_bit(mark);
+      }
+      while (p < end && !is_string_mark(*p)) p++;
+      return p;
+    }
+
+    static constexpr til::simd_kernels table(const char *name) {
+      return { name, skip_blanks, skip_word, find_newline, find_comment_mark, find_string_mark };
+    }
+  };
+
+} // namespace
+
+#endif
@@ -0,0 +1,285 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <cdk/ast/sequence_node.h>
+#include <cdk/ast/expression_node.h>
+#include <cdk/ast/lvalue_node.h>
+#include ".auto/all_nodes.h"
+#include "til_parser.tab.h"
+#include "interner.h"
+#include "mapped_source.h"
+#include "options.h"
+#include "simd_scanner.h"
+
+#define INTERN(s) (&til::interner::instance().intern(s))
+
+namespace {
+
+  struct keyword {
+    std::string_view text;
+    int token;
+  };
+
+  // the keywords of til_scanner.l
+  const keyword keywords[] = {
+    { "int", tTYPE_INT }, { "double", tTYPE_DOUBLE }, { "string", tTYPE_STRING }, { "void", tTYPE_VOID },
+    { "external", tEXTERNAL }, { "forward", tFORWARD }, { "public", tPUBLIC }, { "var", tVAR },
+    { "block", tBLOCK }, { "if", tIF }, { "loop", tLOOP }, { "stop", tSTOP }, { "next", tNEXT },
+    { "return", tRETURN }, { "print", tPRINT }, { "println", tPRINTLN },
+    { "read", tREAD }, { "null", tNULL }, { "set", tSET }, { "index", tINDEX }, { "objects", tOBJECTS },
+    { "sizeof", tSIZEOF }, { "function", tFUNCTION }, { "program", tPROGRAM },
+  };
+
+  inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+  }
+  inline bool is_octal(char c) {
+    return c >= '0' && c <= '7';
+  }
+  inline bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+  }
+  inline bool is_alnum(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  template<typename P>
+  size_t run(const char *p, const char *end, P pred) {
+    const char *q = p;
+    while (q < end && pred(*q)) q++;
+    return q - p;
+  }
+
+  // length of {EXP} at p (0 if there is none)
+  size_t exponent(const char *p, const char *end) {
+    if (p == end || (*p != 'e' && *p != 'E')) return 0;
+    size_t n = 1;
+    if (p + n < end && (p[n] == '+' || p[n] == '-')) n++;
+    size_t digits = run(p + n, end, is_digit);
+    return digits == 0 ? 0 : n + digits;
+  }
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+til::simd_scanner::simd_scanner(const char *data, size_t size, const simd_kernels &kernels) :
+    _p(data), _end(data + size), _kernels(kernels) {
+}
+
+til::simd_scanner *til::simd_scanner::selected(const std::string &input) {
+  static std::unique_ptr<simd_scanner> scanner = [&input]() -> std::unique_ptr<simd_scanner> {
+    mapped_source::instance().input(input);
+    const std::string &name = til::options::instance().scanner();
+    const simd_kernels *kernels = nullptr;
+    if (name == "simd") kernels = &best_kernels();
+    else if (name == "avx2") kernels = &avx2_kernels;
+    else if (name == "sse2") kernels = &sse2_kernels;
+    else if (name == "scalar") kernels = &scalar_kernels;
+    if (kernels == nullptr || !mapped_source::instance().map_input()) return nullptr;
+    const mapped_source &source = mapped_source::instance();
+    return std::make_unique<simd_scanner>(source.data(), source.size(), *kernels);
+  }();
+  return scanner.get();
+}
+
+// same as flex's LexerError
+void til::simd_scanner::error(const char *message) {
+  std::cerr << message << std::endl;
+  std::exit(2);
+}
+
+//---------------------------------------------------------------------------
+
+int til::simd_scanner::scan() {
+  for (;;) {
+    _p = _kernels.skip_blanks(_p, _end, _lineno);
+    if (_p == _end) return 0;
+
+    char c = *_p;
+    char next = _p + 1 < _end ? _p[1] : '\0';
+    if (c == ';') {
+      _p = _kernels.find_newline(_p, _end);
+      continue;
+    }
+    if (c == '/' && next == '*') {
+      _p += 2;
+      if (!comment()) return 0;
+      continue;
+    }
+
+    if (is_alnum(c) && !is_digit(c)) return word();
+    if (is_digit(c) || (c == '.' && is_digit(next))) return number();
+    if (c == '"') return string();
+
+    int two = 0;
+    if (next == '=') {
+      if (c == '<') two = tLE;
+      else if (c == '>') two = tGE;
+      else if (c == '=') two = tEQ;
+      else if (c == '!') two = tNE;
+    } else if (c == '&' && next == '&') two = tAND;
+    else if (c == '|' && next == '|') two = tOR;
+    if (two != 0) {
+      _p += 2;
+      return two;
+    }
+
+    if (c != '\0' && std::strchr("-()<>+*/%@?~!", c) != nullptr) {
+      _p++;
+      return c;
+    }
+    error("Unknown character");
+  }
+}
+
+// the comment opened by the "/*" just scanned, with nested comments
+// @return false if the input ends first
+bool til::simd_scanner::comment() {
+  int depth = 1;
+  while (depth > 0) {
+    _p = _kernels.find_comment_mark(_p, _end, _lineno);
+    if (_p == _end) return false;
+    if (_p + 1 < _end && _p[0] == '*' && _p[1] == '/') {
+      depth--;
+      _p += 2;
+    } else if (_p + 1 < _end && _p[0] == '/' && _p[1] == '*') {
+      depth++;
+      _p += 2;
+    } else {
+      _p++;
+    }
+  }
+  return true;
+}
+
+int til::simd_scanner::word() {
+  const char *start = _p;
+  _p = _kernels.skip_word(_p, _end);
+  std::string_view text(start, _p - start);
+  for (const keyword &k : keywords) {
+    if (k.text == text) return k.token;
+  }
+  yylval.s = INTERN(text);
+  return tIDENTIFIER;
+}
+
+// flex's longest match among the integer and double rules (the first rule wins ties)
+int til::simd_scanner::number() {
+  enum { DECIMAL, BAD_DECIMAL, BAD_HEX_ZERO, HEX, BAD_HEX, DOUBLE, RULES };
+  size_t length[RULES] = {};
+
+  const char *p = _p;
+  size_t digits = run(p, _end, is_digit);
+  if (digits > 0) {
+    if (*p != '0') length[DECIMAL] = digits;
+    else {
+      length[DECIMAL] = 1;
+      if (digits > 1) length[BAD_DECIMAL] = digits;
+    }
+  }
+  if (digits == 1 && *p == '0' && p + 1 < _end && p[1] == 'x') {
+    length[BAD_HEX_ZERO] = 2 + run(p + 2, _end, [](char c) { return c == '0'; });
+    if (size_t hex = run(p + 2, _end, is_hex)) length[HEX] = 2 + hex;
+    if (size_t alnum = run(p + 2, _end, is_alnum)) length[BAD_HEX] = 2 + alnum;
+  }
+  if (p + digits < _end && p[digits] == '.') {
+    size_t fraction = run(p + digits + 1, _end, is_digit);
+    if (digits > 0 || fraction > 0) {
+      length[DOUBLE] = digits + 1 + fraction + exponent(p + digits + 1 + fraction, _end);
+    }
+  } else if (digits > 0) {
+    if (size_t e = exponent(p + digits, _end)) length[DOUBLE] = digits + e;
+  }
+
+  int rule = 0;
+  for (int r = 1; r < RULES; r++) {
+    if (length[r] > length[rule]) rule = r;
+  }
+  std::string text(p, length[rule]);
+  _p += length[rule];
+
+  try {
+    switch (rule) {
+      case DECIMAL:
+        yylval.i = std::stoi(text, nullptr, 10);
+        return tINTEGER;
+      case HEX:
+        yylval.i = std::stoi(text, nullptr, 16);
+        return tINTEGER;
+      case DOUBLE:
+        yylval.d = std::stod(text);
+        return tDOUBLE;
+      case BAD_DECIMAL:
+        error("invalid base 10 integer literal");
+      default:
+        error("invalid base 16 integer literal");
+    }
+  } catch (const std::out_of_range&) {
+    error(rule == DOUBLE ? "double overflow" : "integer overflow");
+  }
+}
+
+// a string literal: escape sequences as in til_scanner.l; after "\0", the
+// rest of the literal is checked but ignored
+int til::simd_scanner::string() {
+  const char *start = ++_p;
+  bool copied = false;
+  bool ignoring = false;
+
+  for (;;) {
+    _p = _kernels.find_string_mark(_p, _end);
+    if (_p == _end) return 0;
+
+    char c = *_p;
+    if (c == '"') break;
+    if (c == '\n') error("newline in string");
+    if (c == '\0') error("null byte in string");
+
+    // a backslash
+    if (_p + 1 == _end) return 0;
+    char e = _p[1];
+    if (ignoring) {
+      _p += e == '"' || e == '\\' ? 2 : 1;
+      continue;
+    }
+    if (!copied) {
+      _string.clear();
+      copied = true;
+    }
+    _string.append(start, _p - start);
+    _p += 2;
+    switch (e) {
+      case 't': _string += '\t'; break;
+      case 'n': _string += '\n'; break;
+      case 'r': _string += '\r'; break;
+      case '\n': error("newline in string");
+      case '\0': break;
+      default:
+        if (!is_octal(e)) {
+          _string += e;
+        } else if (e == '0' && (_p == _end || !is_octal(*_p))) {
+          ignoring = true;
+        } else {
+          int value = e - '0';
+          for (int n = 1; n < 3 && _p < _end && is_octal(*_p); n++) {
+            value = value * 8 + (*_p++ - '0');
+          }
+          if (value > 255) error("octal escape sequence out of range");
+          _string += static_cast<char>(value);
+        }
+    }
+    if (!ignoring) start = _p;
+  }
+
+  if (copied && !ignoring) _string.append(start, _p - start);
+  std::string &value = _values[_turn ^= 1];
+  if (copied) value.swap(_string);
+  else value.assign(start, _p - start);
+  _p++;
+  yylval.s = &value;
+  return tSTRING;
+}
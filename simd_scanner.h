@@ -0,0 +1,60 @@
+#ifndef __TIL_SIMD_SCANNER_H__
+#define __TIL_SIMD_SCANNER_H__
+
+#include <cstddef>
+#include <string>
+#include "simd_kernels.h"
+
+namespace til {
+
+  /**
+   * Hand-written scanner over the memory-mapped source, an alternative to
+   * the flex scanner (til_scanner.l) producing the same tokens, values,
+   * line numbers and errors. Runs of blanks, comments, identifiers and
+   * string literal characters are skipped a block of 16 or 32 bytes at a
+   * time (see til::simd_kernels).
+   */
+  class simd_scanner {
+    const char *_p;
+    const char *_end;
+    const simd_kernels &_kernels;
+    int _lineno = 1;
+    std::string _string; // string literal with escape sequences
+    std::string _values[2]; // string literals for the parser, used in turn (as in til_scanner.l)
+    int _turn = 0;
+
+  public:
+    simd_scanner(const char *data, size_t size, const simd_kernels &kernels);
+
+    /**
+     * The scanner chosen with TIL_SCANNER for the current compilation. The
+     * first call names the source file (see mapped_source::input()).
+     * @param input the driver's input file (empty: standard input)
+     * @return nullptr if the flex scanner is to be used (the default, or if
+     *         the source file cannot be mapped)
+     */
+    static simd_scanner *selected(const std::string &input);
+
+    const simd_kernels &kernels() const {
+      return _kernels;
+    }
+
+    /** @return the next token (0 at the end of the input); sets yylval */
+    int scan();
+
+    /** Line of the last character scanned. */
+    int lineno() const {
+      return _lineno;
+    }
+
+  private:
+    int word();
+    int number();
+    int string();
+    bool comment();
+    [[noreturn]] void error(const char *message);
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __TIL_TARGETS_ANNOTATIONS_H__
+#define __TIL_TARGETS_ANNOTATIONS_H__
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <cdk/ast/basic_node.h>
+#include <cdk/ast/expression_node.h>
+#include "targets/symbol.h"
+
+namespace til {
+
+  /**
+   * Results of the typing pass: which nodes were already type checked, the
+   * symbol created for each declaration, function and program node, and the
+   * symbol each variable, return and recursive ("@") call refers to.
+   * The folding pass (see constant_folder) adds the value of each constant
+   * expression, and the simpler equivalent of some others (x*1 is x).
+   */
+  class annotations {
+  public:
+    /** Value of a constant expression, of the expression's type (int or double). */
+    using constant = std::variant<int, double>;
+
+  private:
+    std::unordered_set<const cdk::basic_node*> _checked;
+    std::unordered_map<const cdk::basic_node*, std::shared_ptr<til::symbol>> _symbols;
+    std::unordered_map<const cdk::basic_node*, constant> _constants;
+    std::unordered_map<const cdk::basic_node*, cdk::expression_node*> _simplified;
+
+  public:
+    bool checked(const cdk::basic_node *node) const {
+      return _checked.count(node) > 0;
+    }
+    void mark(const cdk::basic_node *node) {
+      _checked.insert(node);
+    }
+
+    std::shared_ptr<til::symbol> symbol(const cdk::basic_node *node) const {
+      auto it = _symbols.find(node);
+      return it == _symbols.end() ? nullptr : it->second;
+    }
+    void symbol(const cdk::basic_node *node, std::shared_ptr<til::symbol> symbol) {
+      _symbols[node] = symbol;
+    }
+
+    /** @return the value of a constant expression, or nullptr */
+    const constant *folded(const cdk::basic_node *node) const {
+      auto it = _constants.find(node);
+      return it == _constants.end() ? nullptr : &it->second;
+    }
+    void folded(const cdk::basic_node *node, constant value) {
+      _constants[node] = value;
+    }
+
+    /** @return an expression that computes the same value with less code, or nullptr */
+    cdk::expression_node *simplified(const cdk::basic_node *node) const {
+      auto it = _simplified.find(node);
+      return it == _simplified.end() ? nullptr : it->second;
+    }
+    void simplified(const cdk::basic_node *node, cdk::expression_node *equivalent) {
+      _simplified[node] = equivalent;
+    }
+
+    size_t size() const {
+      return _checked.size();
+    }
+
+    /** Forget every node (before their memory is reused). */
+    void clear() {
+      _checked.clear();
+      _symbols.clear();
+      _constants.clear();
+      _simplified.clear();
+    }
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,7 @@
+#include "targets/asm64_target.h"
+
+/**
+ * Native x86-64.
+ * @var create and register an evaluator for ASM64 targets.
+ */
+til::asm64_target til::asm64_target::_self;
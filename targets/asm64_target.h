@@ -0,0 +1,79 @@
+#ifndef __TIL_TARGETS_ASM64_TARGET_H__
+#define __TIL_TARGETS_ASM64_TARGET_H__
+
+#include <memory>
+#include <vector>
+#include <cdk/targets/basic_target.h>
+#include <cdk/ast/basic_node.h>
+#include "arena.h"
+#include "interner.h"
+#include "timings.h"
+#include "targets/code_generator.h"
+#include "targets/declaration_stream.h"
+#include "ir/x64_lowering.h"
+
+namespace til {
+
+  /**
+   * Native x86-64 code: each top-level node goes through the IR (see
+   * code_generator::lower()) and is written as yasm/nasm assembly for
+   * ELF64, with values in registers (see ir::x64_lowering). Programs link
+   * with a 64-bit build of the runtime, whose functions take SysV calls.
+   */
+  class asm64_target: public cdk::basic_target {
+    static asm64_target _self;
+
+  private:
+    asm64_target() :
+        cdk::basic_target("asm64") {
+    }
+
+  public:
+    bool evaluate(std::shared_ptr<cdk::compiler> compiler) {
+      til::timings::instance().parsed();
+
+      til::declaration_stream &stream = til::declaration_stream::instance();
+      if (stream.declarations() > 0) {
+        std::cerr << "TIL_STREAM: top-level declarations were compiled and released while parsing" << std::endl;
+        return false;
+      }
+      if (stream.cache().enabled()) {
+        std::cerr << "TIL_CACHE: the compile cache keeps postfix code, not IR" << std::endl;
+        return false;
+      }
+      code_generator &generator = stream.generator(compiler);
+      if (!stream.ok() || !generator.annotate(compiler->ast())) return false;
+
+      std::vector<std::unique_ptr<ir::module>> modules;
+      ir::x64_lowering lowering(*compiler->ostream());
+      try {
+        generator.lower(modules);
+        til::timings::probe probe(til::timings::EMIT);
+        for (auto &module : modules) {
+          lowering.write(*module);
+        }
+        lowering.finish();
+      }
+      catch (const ir::unsupported &u) {
+        std::cerr << "asm64: " << u.what << " not supported" << std::endl;
+        return false;
+      }
+
+      if (compiler->debug()) {
+        generator.report(std::cerr);
+        std::cerr << "asm64: " << lowering.functions() << " functions, " << lowering.allocated()
+                  << " values in registers, " << lowering.spilled() << " spilled" << std::endl;
+        til::arena::instance().report(std::cerr);
+        til::interner::instance().report(std::cerr);
+      }
+      stream.finish();
+
+      til::timings::instance().save();
+      return true;
+    }
+
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,347 @@
+#include <cstring>
+#include <string>
+#include "targets/ast_hasher.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::feed(const void *data, size_t size) {
+  auto bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++) {
+    _hash ^= bytes[i];
+    _hash *= 1099511628211ull; // FNV-1a prime
+  }
+}
+
+void til::ast_hasher::feed(long long value) {
+  feed(&value, sizeof(value));
+}
+
+void til::ast_hasher::feed(double value) {
+  feed(&value, sizeof(value));
+}
+
+void til::ast_hasher::feed(std::string_view text) {
+  feed(static_cast<long long>(text.size())); // keeps "ab" "c" apart from "a" "bc"
+  feed(text.data(), text.size());
+}
+
+void til::ast_hasher::feed(std::shared_ptr<cdk::basic_type> type) {
+  if (type == nullptr) {
+    feed("-");
+    return;
+  }
+
+  feed(static_cast<long long>(type->name()));
+  feed(static_cast<long long>(type->size()));
+  if (type->name() == cdk::TYPE_POINTER) {
+    feed(cdk::reference_type::cast(type)->referenced());
+  } else if (type->name() == cdk::TYPE_FUNCTIONAL) {
+    auto function = cdk::functional_type::cast(type);
+    feed(static_cast<long long>(function->input_length()));
+    for (size_t i = 0; i < function->input_length(); i++) {
+      feed(function->input(i));
+    }
+    feed(static_cast<long long>(function->output_length()));
+    for (size_t i = 0; i < function->output_length(); i++) {
+      feed(function->output(i));
+    }
+  }
+}
+
+bool til::ast_hasher::local(const std::string &name) const {
+  for (auto &scope : _locals) {
+    if (scope.count(name) > 0) return true;
+  }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_nil_node(cdk::nil_node * const node, int lvl) {
+  feed("nil");
+}
+void til::ast_hasher::do_data_node(cdk::data_node * const node, int lvl) {
+  feed("data");
+  feed(static_cast<long long>(node->size()));
+}
+
+void til::ast_hasher::processUnaryExpression(const char *tag, cdk::unary_operation_node * const node, int lvl) {
+  feed(tag);
+  node->argument()->accept(this, lvl + 2);
+}
+
+void til::ast_hasher::processBinaryExpression(const char *tag, cdk::binary_operation_node * const node, int lvl) {
+  feed(tag);
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+}
+
+void til::ast_hasher::do_not_node(cdk::not_node * const node, int lvl) {
+  processUnaryExpression("not", node, lvl);
+}
+void til::ast_hasher::do_and_node(cdk::and_node * const node, int lvl) {
+  processBinaryExpression("and", node, lvl);
+}
+void til::ast_hasher::do_or_node(cdk::or_node * const node, int lvl) {
+  processBinaryExpression("or", node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_sequence_node(cdk::sequence_node * const node, int lvl) {
+  feed("sequence");
+  feed(static_cast<long long>(node->size()));
+  for (size_t i = 0; i < node->size(); i++) {
+    node->node(i)->accept(this, lvl);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_integer_node(cdk::integer_node * const node, int lvl) {
+  feed("integer");
+  feed(static_cast<long long>(node->value()));
+}
+
+void til::ast_hasher::do_double_node(cdk::double_node * const node, int lvl) {
+  feed("double");
+  feed(node->value());
+}
+
+void til::ast_hasher::do_string_node(cdk::string_node * const node, int lvl) {
+  feed("string");
+  feed(node->value());
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_unary_minus_node(cdk::unary_minus_node * const node, int lvl) {
+  processUnaryExpression("neg", node, lvl);
+}
+
+void til::ast_hasher::do_unary_plus_node(cdk::unary_plus_node * const node, int lvl) {
+  processUnaryExpression("pos", node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_add_node(cdk::add_node * const node, int lvl) {
+  processBinaryExpression("add", node, lvl);
+}
+void til::ast_hasher::do_sub_node(cdk::sub_node * const node, int lvl) {
+  processBinaryExpression("sub", node, lvl);
+}
+void til::ast_hasher::do_mul_node(cdk::mul_node * const node, int lvl) {
+  processBinaryExpression("mul", node, lvl);
+}
+void til::ast_hasher::do_div_node(cdk::div_node * const node, int lvl) {
+  processBinaryExpression("div", node, lvl);
+}
+void til::ast_hasher::do_mod_node(cdk::mod_node * const node, int lvl) {
+  processBinaryExpression("mod", node, lvl);
+}
+void til::ast_hasher::do_lt_node(cdk::lt_node * const node, int lvl) {
+  processBinaryExpression("lt", node, lvl);
+}
+void til::ast_hasher::do_le_node(cdk::le_node * const node, int lvl) {
+  processBinaryExpression("le", node, lvl);
+}
+void til::ast_hasher::do_ge_node(cdk::ge_node * const node, int lvl) {
+  processBinaryExpression("ge", node, lvl);
+}
+void til::ast_hasher::do_gt_node(cdk::gt_node * const node, int lvl) {
+  processBinaryExpression("gt", node, lvl);
+}
+void til::ast_hasher::do_ne_node(cdk::ne_node * const node, int lvl) {
+  processBinaryExpression("ne", node, lvl);
+}
+void til::ast_hasher::do_eq_node(cdk::eq_node * const node, int lvl) {
+  processBinaryExpression("eq", node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_variable_node(cdk::variable_node * const node, int lvl) {
+  feed("variable");
+  feed(node->name());
+  if (local(node->name())) return;
+
+  // declared outside: the generated code depends on what the name refers to
+  auto symbol = _symtab.find(node->name());
+  if (symbol == nullptr) {
+    feed("?");
+  } else {
+    feed(static_cast<long long>(symbol->qualifier()));
+    feed(symbol->type());
+  }
+}
+
+void til::ast_hasher::do_rvalue_node(cdk::rvalue_node * const node, int lvl) {
+  feed("rvalue");
+  node->lvalue()->accept(this, lvl + 2);
+}
+
+void til::ast_hasher::do_assignment_node(cdk::assignment_node * const node, int lvl) {
+  feed("assignment");
+  node->lvalue()->accept(this, lvl + 2);
+  node->rvalue()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_program_node(til::program_node * const node, int lvl) {
+  feed("program");
+  node->statements()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_evaluation_node(til::evaluation_node * const node, int lvl) {
+  feed("evaluation");
+  node->argument()->accept(this, lvl + 2);
+}
+
+void til::ast_hasher::do_print_node(til::print_node * const node, int lvl) {
+  feed(node->newline() ? "println" : "print");
+  node->argument()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_read_node(til::read_node * const node, int lvl) {
+  feed("read");
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_loop_node(til::loop_node * const node, int lvl) {
+  feed("loop");
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_if_node(til::if_node * const node, int lvl) {
+  feed("if");
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+void til::ast_hasher::do_if_else_node(til::if_else_node * const node, int lvl) {
+  feed("if_else");
+  node->condition()->accept(this, lvl + 2);
+  node->thenblock()->accept(this, lvl + 2);
+  node->elseblock()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_declaration_node(til::declaration_node * const node, int lvl) {
+  feed("declaration");
+  feed(static_cast<long long>(node->qualifier()));
+  feed(node->type());
+  feed(node->identifier());
+
+  if (node->initialValue() != nullptr) {
+    node->initialValue()->accept(this, lvl + 2);
+  }
+
+  // the top-level declaration itself is not local: its type is already part of the hash
+  if (!_locals.empty()) {
+    _locals.back().insert(node->identifier());
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_function_call_node(til::function_call_node * const node, int lvl) {
+  feed("call");
+  if (node->identifier() == nullptr) {
+    feed("@");
+  } else {
+    node->identifier()->accept(this, lvl + 2);
+  }
+  node->arguments()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_function_node(til::function_node * const node, int lvl) {
+  feed("function");
+  feed(node->type());
+
+  _locals.emplace_back();
+  node->arguments()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+  _locals.pop_back();
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_return_node(til::return_node * const node, int lvl) {
+  feed("return");
+  if (node->value() != nullptr) {
+    node->value()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_next_node(til::next_node * const node, int lvl) {
+  feed("next");
+  feed(static_cast<long long>(node->level()));
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_stop_node(til::stop_node * const node, int lvl) {
+  feed("stop");
+  feed(static_cast<long long>(node->level()));
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_block_node(til::block_node * const node, int lvl) {
+  feed("block");
+
+  _locals.emplace_back();
+  node->declarations()->accept(this, lvl + 2);
+  node->instructions()->accept(this, lvl + 2);
+  _locals.pop_back();
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_sizeof_node(til::sizeof_node * const node, int lvl) {
+  feed("sizeof");
+  node->expression()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_objects_node(til::objects_node * const node, int lvl) {
+  processUnaryExpression("objects", node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_null_ptr_node(til::null_ptr_node * const node, int lvl) {
+  feed("null");
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_ptr_index_node(til::ptr_index_node * const node, int lvl) {
+  feed("index");
+  node->base()->accept(this, lvl + 2);
+  node->index()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ast_hasher::do_address_of_node(til::address_of_node * const node, int lvl) {
+  feed("address_of");
+  node->lvalue()->accept(this, lvl + 2);
+}
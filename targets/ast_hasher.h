@@ -0,0 +1,62 @@
+#ifndef __TIL_TARGETS_AST_HASHER_H__
+#define __TIL_TARGETS_AST_HASHER_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "targets/basic_ast_visitor.h"
+
+namespace til {
+
+  /**
+   * Compute a 64-bit fingerprint of a subtree: the node kinds, literals,
+   * names and declared types it contains and, for each name that is not
+   * declared inside the subtree, the type and qualifier of the symbol it
+   * currently refers to. Two subtrees with the same fingerprint generate
+   * the same code.
+   */
+  class ast_hasher: public basic_ast_visitor {
+    cdk::symbol_table<til::symbol> &_symtab;
+    std::vector<std::unordered_set<std::string>> _locals; // names declared inside the subtree
+    uint64_t _hash = 14695981039346656037ull;            // FNV-1a offset basis
+
+  public:
+    ast_hasher(std::shared_ptr<cdk::compiler> compiler, cdk::symbol_table<til::symbol> &symtab) :
+        basic_ast_visitor(compiler), _symtab(symtab) {
+    }
+
+  public:
+    ~ast_hasher() {
+      // EMPTY
+    }
+
+  public:
+    inline uint64_t hash() const {
+      return _hash;
+    }
+
+    void feed(const void *data, size_t size);
+    void feed(long long value);
+    void feed(double value);
+    void feed(std::string_view text);
+    void feed(std::shared_ptr<cdk::basic_type> type);
+
+  protected:
+    bool local(const std::string &name) const;
+    void processUnaryExpression(const char *tag, cdk::unary_operation_node *const node, int lvl);
+    void processBinaryExpression(const char *tag, cdk::binary_operation_node *const node, int lvl);
+
+  public:
+    // do not edit these lines
+#define __IN_VISITOR_HEADER__
+#include ".auto/visitor_decls.h"       // automatically generated
+#undef __IN_VISITOR_HEADER__
+    // do not edit these lines: end
+
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef __TIL_TARGETS_CHUNKED_OUTPUT_H__
+#define __TIL_TARGETS_CHUNKED_OUTPUT_H__
+
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace til {
+
+  /**
+   * Stream buffer that collects output in a large chunk and hands it to the
+   * underlying buffer in bulk, so the many small writes done by the postfix
+   * emitter do not each reach the output file.
+   */
+  class chunked_output: public std::streambuf {
+    std::streambuf *_target;
+    std::vector<char> _chunk;
+    size_t _bytes = 0;  // bytes already handed to the target
+    size_t _writes = 0; // bulk writes to the target
+
+  public:
+    explicit chunked_output(std::streambuf *target, size_t chunk_size = 1 << 20) :
+        _target(target), _chunk(chunk_size) {
+      setp(_chunk.data(), _chunk.data() + _chunk.size());
+    }
+
+    ~chunked_output() {
+      drain();
+    }
+
+    std::streambuf *target() const {
+      return _target;
+    }
+    size_t bytes() const {
+      return _bytes + (pptr() - pbase());
+    }
+    size_t writes() const {
+      return _writes;
+    }
+
+  protected:
+    int_type overflow(int_type c) override {
+      if (!drain()) return traits_type::eof();
+      if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+      }
+      return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+      if (n > epptr() - pptr()) {
+        if (!drain()) return 0;
+        if (n >= static_cast<std::streamsize>(_chunk.size())) { // too large to be worth copying
+          std::streamsize written = _target->sputn(s, n);
+          _bytes += written;
+          _writes++;
+          return written;
+        }
+      }
+      std::memcpy(pptr(), s, n);
+      pbump(static_cast<int>(n));
+      return n;
+    }
+
+    // std::endl flushes after every line: keep collecting and drain only
+    // when the chunk is full or the owner asks for it
+    int sync() override {
+      return 0;
+    }
+
+  public:
+    /** Hand everything collected so far to the target. */
+    bool drain() {
+      std::streamsize n = pptr() - pbase();
+      if (n == 0) return true;
+
+      std::streamsize written = _target->sputn(pbase(), n);
+      _bytes += written;
+      _writes++;
+      setp(_chunk.data(), _chunk.data() + _chunk.size());
+      return written == n && _target->pubsync() == 0;
+    }
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <functional>
+#include "targets/code_generator.h"
+#include "targets/constant_folder.h"
+#include "targets/ir_builder.h"
+#include "ir/postfix_lowering.h"
+#include "targets/postfix_writer.h"
+#include "targets/type_annotator.h"
+#include "timings.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+//---------------------------------------------------------------------------
+
+bool til::code_generator::annotate(cdk::basic_node *const ast) {
+  til::timings::probe probe(til::timings::CHECK);
+  if (auto file = dynamic_cast<cdk::sequence_node*>(ast)) {
+    for (size_t i = 0; i < file->size(); i++) {
+      add(file->node(i));
+    }
+  } else {
+    add(ast);
+  }
+  return _annotator.ok();
+}
+
+bool til::code_generator::add(cdk::basic_node *const node) {
+  // each unit's key depends on the declarations before it: look it up before typing the unit
+  size_t space = _written + _units.size() + 1;
+  unit &u = _units.emplace_back();
+  u.node = node;
+  if (_cache.enabled()) {
+    u.key = _cache.key(_compiler, u.node, _symtab);
+    u.cached = _cache.load(u.key, space, u.code, u.externals);
+  }
+
+  if (u.cached) {
+    _annotator.declare(u.node);
+  } else {
+    u.node->accept(&_annotator, 0);
+    if (_annotator.ok()) {
+      til::constant_folder folder(_compiler, _annotations);
+      u.node->accept(&folder, 0);
+      _folded += folder.folded();
+      _simplified += folder.simplified();
+    }
+  }
+
+  return _annotator.ok();
+}
+
+//---------------------------------------------------------------------------
+
+void til::code_generator::flush(til::postfix_buffer &code) {
+  til::timings::probe probe(til::timings::CODEGEN);
+
+  // each unit gets its own symbol table and label namespace (its position + 1)
+  std::function<void(size_t)> write = [this](size_t i) {
+    unit &u = _units[i];
+    if (u.cached) return;
+
+    try {
+      size_t space = _written + i + 1;
+      if (_ir) {
+        try {
+          ir::module module(space);
+          til::ir_builder builder(_compiler, _annotations, module);
+          u.node->accept(&builder, 0);
+          ir::pass_manager passes = ir::pass_manager::standard(_compiler->debug());
+          passes.run(module);
+          ir::postfix_lowering lowering(module, u.code);
+          lowering.run();
+          u.externals = module.externals();
+          u.frames = {lowering.frames(), lowering.bytes(), lowering.bytes()};
+          u.passes = passes.changed();
+          u.lowered = true;
+        }
+        catch (const ir::unsupported &) {
+          u.code.code().clear();
+        }
+      }
+      if (!u.lowered) {
+        cdk::symbol_table<til::symbol> symtab;
+        postfix_writer writer(_compiler, symtab, u.code, _annotations, space);
+        u.node->accept(&writer, 0);
+        u.externals = writer.externalFunctions();
+        u.frames = writer.frameUsage();
+      }
+      if (_optimize) {
+        u.peephole.run(u.code);
+      }
+      if (_cache.enabled()) {
+        _cache.store(u.key, space, u.code, u.externals);
+      }
+    }
+    catch (...) {
+      u.error = std::current_exception();
+    }
+  };
+
+  size_t jobs = std::min<size_t>(_jobs, _units.size());
+  if (jobs <= 1) {
+    for (size_t i = 0; i < _units.size(); i++) {
+      write(i);
+    }
+  } else {
+    if (!_pool) _pool = std::make_unique<til::worker_pool>(_jobs);
+    _pool->run(_units.size(), write);
+  }
+
+  // later units override earlier ones: a definition cancels a previous forward declaration
+  for (auto &u : _units) {
+    if (u.error) std::rethrow_exception(u.error);
+    code.append(std::move(u.code));
+    for (auto &[name, needed] : u.externals) {
+      _externals[name] = needed;
+    }
+    _frames.frames += u.frames.frames;
+    _frames.bytes += u.frames.bytes;
+    _frames.unshared += u.frames.unshared;
+    _peephole.merge(u.peephole);
+    if (!u.cached && _ir) {
+      (u.lowered ? _lowered : _fallbacks)++;
+      for (auto &[pass, changed] : u.passes) {
+        _passes[pass] += changed;
+      }
+    }
+  }
+
+  discard();
+}
+
+void til::code_generator::lower(std::vector<std::unique_ptr<ir::module>> &modules) {
+  til::timings::probe probe(til::timings::CODEGEN);
+  for (size_t i = 0; i < _units.size(); i++) {
+    ir::module &module = *modules.emplace_back(std::make_unique<ir::module>(_written + i + 1));
+    til::ir_builder builder(_compiler, _annotations, module);
+    _units[i].node->accept(&builder, 0);
+    ir::pass_manager passes = ir::pass_manager::standard(_compiler->debug());
+    passes.run(module);
+    _lowered++;
+    for (auto &[pass, changed] : passes.changed()) {
+      _passes[pass] += changed;
+    }
+  }
+  discard();
+}
+
+void til::code_generator::discard() {
+  _written += _units.size();
+  _units.clear();
+  _annotations.clear();
+}
+
+void til::code_generator::generate(til::postfix_buffer &code) {
+  flush(code);
+  for (auto &[name, needed] : _externals) {
+    if (needed) {
+      code.EXTERN(name);
+    }
+  }
+}
+
+void til::code_generator::report(std::ostream &os) const {
+  os << "frames: " << _frames.frames << " frames, " << _frames.bytes << " bytes of locals ("
+     << _frames.unshared - _frames.bytes << " bytes saved by sharing slots)" << std::endl;
+  os << "folding: " << _folded << " constants, " << _simplified << " simplifications" << std::endl;
+  if (_ir || _lowered > 0) {
+    os << "ir: " << _lowered << " units lowered, " << _fallbacks << " left to the postfix writer";
+    for (auto &[pass, changed] : _passes) {
+      os << ", " << pass << " changed " << changed << " functions";
+    }
+    os << std::endl;
+  }
+  if (_optimize) {
+    _peephole.report(os);
+  }
+}
@@ -0,0 +1,125 @@
+#ifndef __TIL_TARGETS_CODE_GENERATOR_H__
+#define __TIL_TARGETS_CODE_GENERATOR_H__
+
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cdk/compiler.h>
+#include <cdk/ast/basic_node.h>
+#include "targets/annotations.h"
+#include "targets/compile_cache.h"
+#include "targets/peephole.h"
+#include "targets/postfix_buffer.h"
+#include "targets/postfix_writer.h"
+#include "targets/type_annotator.h"
+#include "targets/worker_pool.h"
+#include "ir/passes.h"
+
+namespace til {
+
+  /**
+   * Generate postfix code for each top-level declaration (and the program)
+   * with a writer, label namespace and buffer of its own, and merge the
+   * results in source order. With more than one job, the top-level nodes
+   * are handed out to a pool of threads, kept for every flush(); the
+   * merged code is the same.
+   * Declarations found in the compile cache are neither checked in depth
+   * nor written again. The others have their constant expressions folded
+   * (see constant_folder) once typed, and their code is optimized (see
+   * peephole) before it is cached and merged. With the IR on, a unit is
+   * first lowered to the IR (see ir_builder), optimized by the standard
+   * passes and written back as postfix code (see ir::postfix_lowering);
+   * units with constructs the IR does not handle go to the postfix writer.
+   *
+   * Top-level nodes may also be handed over a few at a time (add(), then
+   * flush()), as the parser completes them: once written, they are no
+   * longer needed. Targets other than postfix take the IR modules instead
+   * (lower()).
+   */
+  class code_generator {
+    struct unit {
+      cdk::basic_node *node;
+      uint64_t key = 0;
+      bool cached = false;
+      til::postfix_buffer code;
+      std::map<std::string, bool> externals;
+      postfix_writer::frame_usage frames;
+      til::peephole peephole;
+      bool lowered = false;               // through the IR
+      std::map<std::string, size_t> passes; // functions changed by each IR pass
+      std::exception_ptr error;
+    };
+
+    std::shared_ptr<cdk::compiler> _compiler;
+    til::annotations &_annotations;
+    til::compile_cache &_cache;
+    unsigned _jobs;
+    std::unique_ptr<til::worker_pool> _pool; // started by the first flush with more than one unit
+    bool _optimize;
+    bool _ir;
+    cdk::symbol_table<til::symbol> _symtab; // global declarations seen so far
+    til::type_annotator _annotator;
+    std::vector<unit> _units;               // typed, not yet written
+    size_t _written = 0;                    // units written so far
+    std::map<std::string, bool> _externals;
+    postfix_writer::frame_usage _frames;    // of the units written (not those from the cache)
+    size_t _folded = 0;                     // expressions replaced by their value
+    size_t _simplified = 0;                 // expressions replaced by an operand
+    til::peephole _peephole;                // rules fired in the units written
+    size_t _lowered = 0;                    // units written through the IR
+    size_t _fallbacks = 0;                  // units the IR did not handle
+    std::map<std::string, size_t> _passes;  // functions changed by each IR pass
+
+  public:
+    code_generator(std::shared_ptr<cdk::compiler> compiler, til::annotations &annotations, til::compile_cache &cache,
+                   unsigned jobs = 1, bool optimize = true, bool ir = false) :
+        _compiler(compiler), _annotations(annotations), _cache(cache), _jobs(jobs), _optimize(optimize), _ir(ir),
+        _annotator(compiler, _symtab, annotations) {
+    }
+
+  public:
+    /** Type the tree, one top-level node at a time; false if there were errors. */
+    bool annotate(cdk::basic_node *const ast);
+
+    /** Type one more top-level node (not timed); false if there were errors in any node so far. */
+    bool add(cdk::basic_node *const node);
+
+    /** Top-level nodes typed but not yet written. */
+    size_t pending() const {
+      return _units.size();
+    }
+
+    /**
+     * Write the code for the pending nodes and forget them (and their
+     * annotations), so that their memory may be released.
+     */
+    void flush(til::postfix_buffer &code);
+
+    /**
+     * Lower the pending nodes to the IR instead, one module each in source
+     * order, optimized by the standard passes, and forget them. Throws
+     * ir::unsupported for constructs the IR does not handle: there is no
+     * postfix writer to fall back to.
+     */
+    void lower(std::vector<std::unique_ptr<ir::module>> &modules);
+
+    /** Forget the pending nodes without writing them (after errors). */
+    void discard();
+
+    /** Write the code for the annotated tree, followed by the EXTERN declarations. */
+    void generate(til::postfix_buffer &code);
+
+    /**
+     * Debug summary: stack frame bytes (and bytes saved by sharing slots between scopes), folded expressions,
+     * units written through the IR and the functions each IR pass changed, peephole rules.
+     */
+    void report(std::ostream &os) const;
+  };
+
+} // til
+
+#endif
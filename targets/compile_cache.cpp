@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include "targets/compile_cache.h"
+#include "targets/ast_hasher.h"
+#include "options.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+namespace {
+  const char *const FORMAT = "til-cache 2";
+}
+
+//---------------------------------------------------------------------------
+
+til::compile_cache::compile_cache(const std::string &directory) :
+    _directory(directory) {
+  if (!enabled()) return;
+
+  std::error_code error;
+  std::filesystem::create_directories(_directory, error);
+
+  // a rebuilt compiler may generate different code: its entries must not be reused
+  const std::filesystem::path self("/proc/self/exe");
+  auto size = std::filesystem::file_size(self, error);
+  auto time = std::filesystem::last_write_time(self, error);
+  if (!error) {
+    _build = size ^ (static_cast<uint64_t>(time.time_since_epoch().count()) * 1099511628211ull);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+std::string til::compile_cache::path(uint64_t key) const {
+  char name[20];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+  return _directory + "/" + name + ".pf";
+}
+
+uint64_t til::compile_cache::key(std::shared_ptr<cdk::compiler> compiler, cdk::basic_node *const node,
+                                 cdk::symbol_table<til::symbol> &symtab) const {
+  til::ast_hasher hasher(compiler, symtab);
+  hasher.feed(FORMAT);
+  hasher.feed(static_cast<long long>(_build));
+  hasher.feed(static_cast<long long>(til::options::instance().peephole())); // optimized code or not
+  hasher.feed(static_cast<long long>(til::options::instance().ir()));       // written through the IR or not
+  node->accept(&hasher, 0);
+  return hasher.hash();
+}
+
+//---------------------------------------------------------------------------
+
+bool til::compile_cache::load(uint64_t key, int space, til::postfix_buffer &code,
+                              std::map<std::string, bool> &externals) {
+  std::ifstream is(path(key), std::ios::binary);
+  std::string format;
+  int saved_space;
+  size_t count;
+  bool ok = is && std::getline(is, format) && format == FORMAT && is >> saved_space >> count;
+  for (size_t i = 0; ok && i < count; i++) {
+    std::string name;
+    bool needed;
+    ok = static_cast<bool>(is >> needed >> name);
+    externals[name] = needed;
+  }
+
+  ok = ok && is.get() == '\n' && code.read(is);
+  if (!ok) {
+    code.code().clear();
+    externals.clear();
+    _misses++;
+    return false;
+  }
+
+  code.relabel(saved_space, space);
+  _hits++;
+  return true;
+}
+
+void til::compile_cache::store(uint64_t key, int space, const til::postfix_buffer &code,
+                               const std::map<std::string, bool> &externals) {
+  std::string target = path(key);
+  std::string temporary = target + "." + std::to_string(::getpid()) + "."
+                          + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream os(temporary, std::ios::binary);
+    os << FORMAT << '\n' << space << ' ' << externals.size() << '\n';
+    for (auto &[name, needed] : externals) {
+      os << needed << ' ' << name << '\n';
+    }
+    code.write(os);
+    if (!os) {
+      _failures++;
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, target, error);
+  if (error) {
+    _failures++;
+    std::remove(temporary.c_str());
+  } else {
+    _stores++;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::compile_cache::report(std::ostream &os) const {
+  if (!enabled()) return;
+  size_t lookups = _hits + _misses;
+  os << "cache: " << _hits << " hits, " << _misses << " misses";
+  if (lookups > 0) os << " (" << 100 * _hits / lookups << "% hit rate)";
+  os << ", " << _stores << " stored";
+  if (_failures > 0) os << ", " << _failures << " failed writes";
+  os << " in " << _directory << std::endl;
+}
@@ -0,0 +1,56 @@
+#ifndef __TIL_TARGETS_COMPILE_CACHE_H__
+#define __TIL_TARGETS_COMPILE_CACHE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <cdk/compiler.h>
+#include <cdk/symbol_table.h>
+#include <cdk/ast/basic_node.h>
+#include "targets/postfix_buffer.h"
+#include "targets/symbol.h"
+
+namespace til {
+
+  /**
+   * On-disk cache of the code generated for top-level declarations. Entries
+   * are named by a fingerprint of the declaration (see ast_hasher) and of the
+   * compiler executable, and hold the postfix code and external functions
+   * of the declaration. Several compilers may share a directory: entries are
+   * written to a temporary file and renamed into place.
+   */
+  class compile_cache {
+    std::string _directory; // empty: no cache
+    uint64_t _build = 0;    // fingerprint of the compiler executable
+
+    std::atomic<size_t> _hits{0}, _misses{0}, _stores{0}, _failures{0};
+
+  public:
+    explicit compile_cache(const std::string &directory);
+
+  public:
+    bool enabled() const {
+      return !_directory.empty();
+    }
+
+    /** Fingerprint of a top-level node, with names resolved in the current scope. */
+    uint64_t key(std::shared_ptr<cdk::compiler> compiler, cdk::basic_node *const node,
+                 cdk::symbol_table<til::symbol> &symtab) const;
+
+    /** Fetch an entry, renaming its labels to the given namespace. */
+    bool load(uint64_t key, int space, til::postfix_buffer &code, std::map<std::string, bool> &externals);
+
+    void store(uint64_t key, int space, const til::postfix_buffer &code, const std::map<std::string, bool> &externals);
+
+    void report(std::ostream &os) const;
+
+  private:
+    std::string path(uint64_t key) const;
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,430 @@
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include "targets/constant_folder.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using constant = til::annotations::constant;
+
+  // the postfix machine's 32-bit arithmetic
+  int wrap(long long value) {
+    return static_cast<int>(static_cast<uint32_t>(value));
+  }
+
+  double real(const constant &value) {
+    return std::visit([](auto v) { return static_cast<double>(v); }, value);
+  }
+
+  bool is(const constant *value, int i) {
+    return value != nullptr && std::holds_alternative<int>(*value) && std::get<int>(*value) == i;
+  }
+  bool is(const constant *value, double d) {
+    return value != nullptr && std::holds_alternative<double>(*value) && std::get<double>(*value) == d;
+  }
+
+  // whether leaving out the expression changes nothing but the value computed:
+  // no calls, assignments, reads or allocations, and nothing that may trap
+  bool pure(const til::annotations &annotations, cdk::expression_node *const node) {
+    if (annotations.folded(node)) return true;
+    if (dynamic_cast<cdk::integer_node*>(node) || dynamic_cast<cdk::double_node*>(node)
+        || dynamic_cast<cdk::string_node*>(node) || dynamic_cast<til::null_ptr_node*>(node)
+        || dynamic_cast<til::sizeof_node*>(node)) {
+      return true;
+    }
+    if (auto rvalue = dynamic_cast<cdk::rvalue_node*>(node)) {
+      return dynamic_cast<cdk::variable_node*>(rvalue->lvalue()) != nullptr;
+    }
+    if (auto address = dynamic_cast<til::address_of_node*>(node)) {
+      return dynamic_cast<cdk::variable_node*>(address->lvalue()) != nullptr;
+    }
+    if (auto unary = dynamic_cast<cdk::unary_operation_node*>(node)) {
+      return pure(annotations, unary->argument());
+    }
+    if (dynamic_cast<cdk::div_node*>(node) || dynamic_cast<cdk::mod_node*>(node)) {
+      return false;
+    }
+    if (auto binary = dynamic_cast<cdk::binary_operation_node*>(node)) {
+      return pure(annotations, binary->left()) && pure(annotations, binary->right());
+    }
+    return false;
+  }
+
+} // namespace
+
+void til::constant_folder::fold(cdk::expression_node *const node, til::annotations::constant value) {
+  _annotations.folded(node, value);
+  _folded++;
+}
+
+void til::constant_folder::simplify(cdk::expression_node *const node, cdk::expression_node *const equivalent) {
+  _annotations.simplified(node, equivalent);
+  _simplified++;
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_nil_node(cdk::nil_node * const node, int lvl) {
+  // EMPTY
+}
+void til::constant_folder::do_data_node(cdk::data_node * const node, int lvl) {
+  // EMPTY
+}
+
+void til::constant_folder::do_not_node(cdk::not_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+  auto value = _annotations.folded(node->argument());
+  if (value != nullptr && std::holds_alternative<int>(*value)) {
+    fold(node, std::get<int>(*value) == 0 ? 1 : 0);
+  }
+}
+
+// left; DUP; JZ end; right; AND -- a zero left operand is the result, otherwise both are combined bitwise
+void til::constant_folder::do_and_node(cdk::and_node * const node, int lvl) {
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (is(left, 0)) {
+    fold(node, 0);
+  } else if (left != nullptr && right != nullptr && std::holds_alternative<int>(*left)
+             && std::holds_alternative<int>(*right)) {
+    fold(node, std::get<int>(*left) & std::get<int>(*right));
+  }
+}
+
+// left; DUP; JNZ end; right; OR -- a nonzero left operand is the result, otherwise the right one is
+void til::constant_folder::do_or_node(cdk::or_node * const node, int lvl) {
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (left == nullptr || !std::holds_alternative<int>(*left)) return;
+  if (std::get<int>(*left) != 0) {
+    fold(node, *left);
+  } else if (right != nullptr && std::holds_alternative<int>(*right)) {
+    fold(node, *right);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_sequence_node(cdk::sequence_node * const node, int lvl) {
+  for (size_t i = 0; i < node->size(); i++) {
+    node->node(i)->accept(this, lvl);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_integer_node(cdk::integer_node * const node, int lvl) {
+  _annotations.folded(node, node->value());
+}
+
+void til::constant_folder::do_double_node(cdk::double_node * const node, int lvl) {
+  _annotations.folded(node, node->value());
+}
+
+void til::constant_folder::do_string_node(cdk::string_node * const node, int lvl) {
+  // EMPTY
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_unary_minus_node(cdk::unary_minus_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+  auto value = _annotations.folded(node->argument());
+  if (value == nullptr) return;
+  if (node->is_typed(cdk::TYPE_DOUBLE)) {
+    fold(node, -real(*value));
+  } else if (std::holds_alternative<int>(*value)) {
+    fold(node, wrap(-static_cast<long long>(std::get<int>(*value))));
+  }
+}
+
+void til::constant_folder::do_unary_plus_node(cdk::unary_plus_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+  if (auto value = _annotations.folded(node->argument())) {
+    fold(node, node->is_typed(cdk::TYPE_DOUBLE) ? constant(real(*value)) : *value);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// int operands give an int (wrapped to 32 bits); with a double operand, the other is promoted
+void til::constant_folder::processArithmetic(cdk::binary_operation_node *const node, int lvl,
+                                             const std::function<bool(long long, long long, long long&)> &integer,
+                                             const std::function<bool(double, double, double&)> &real) {
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (left == nullptr || right == nullptr) return;
+
+  if (node->is_typed(cdk::TYPE_INT)) {
+    if (!std::holds_alternative<int>(*left) || !std::holds_alternative<int>(*right)) return;
+    long long result;
+    if (integer(std::get<int>(*left), std::get<int>(*right), result)) {
+      fold(node, wrap(result));
+    }
+  } else if (node->is_typed(cdk::TYPE_DOUBLE)) {
+    double result;
+    if (real(::real(*left), ::real(*right), result) && std::isfinite(result)) {
+      fold(node, result);
+    }
+  }
+}
+
+void til::constant_folder::do_add_node(cdk::add_node * const node, int lvl) {
+  processArithmetic(node, lvl,
+                    [](long long a, long long b, long long &r) { r = a + b; return true; },
+                    [](double a, double b, double &r) { r = a + b; return true; });
+  if (_annotations.folded(node) || !node->is_typed(cdk::TYPE_INT)) return;
+
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (is(right, 0) && node->left()->is_typed(cdk::TYPE_INT)) {
+    simplify(node, node->left());
+  } else if (is(left, 0) && node->right()->is_typed(cdk::TYPE_INT)) {
+    simplify(node, node->right());
+  }
+}
+
+void til::constant_folder::do_sub_node(cdk::sub_node * const node, int lvl) {
+  processArithmetic(node, lvl,
+                    [](long long a, long long b, long long &r) { r = a - b; return true; },
+                    [](double a, double b, double &r) { r = a - b; return true; });
+  if (_annotations.folded(node) || !node->is_typed(cdk::TYPE_INT)) return;
+
+  if (is(_annotations.folded(node->right()), 0) && node->left()->is_typed(cdk::TYPE_INT)) {
+    simplify(node, node->left());
+  }
+}
+
+void til::constant_folder::do_mul_node(cdk::mul_node * const node, int lvl) {
+  processArithmetic(node, lvl,
+                    [](long long a, long long b, long long &r) { r = a * b; return true; },
+                    [](double a, double b, double &r) { r = a * b; return true; });
+  if (_annotations.folded(node)) return;
+
+  // x*1.0 is exact, but x*0.0 and x+0.0 are not identities for doubles (NaN, infinities, -0.0)
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (node->is_typed(cdk::TYPE_INT)) {
+    if (is(right, 1)) {
+      simplify(node, node->left());
+    } else if (is(left, 1)) {
+      simplify(node, node->right());
+    } else if ((is(right, 0) && pure(_annotations, node->left())) || (is(left, 0) && pure(_annotations, node->right()))) {
+      fold(node, 0);
+    }
+  } else if (node->left()->is_typed(cdk::TYPE_DOUBLE) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
+    if (is(right, 1.0)) {
+      simplify(node, node->left());
+    } else if (is(left, 1.0)) {
+      simplify(node, node->right());
+    }
+  }
+}
+
+void til::constant_folder::do_div_node(cdk::div_node * const node, int lvl) {
+  processArithmetic(node, lvl,
+                    [](long long a, long long b, long long &r) {
+                      if (b == 0 || (a == INT_MIN && b == -1)) return false; // traps at run time
+                      r = a / b;
+                      return true;
+                    },
+                    [](double a, double b, double &r) {
+                      if (b == 0) return false;
+                      r = a / b;
+                      return true;
+                    });
+  if (_annotations.folded(node)) return;
+
+  auto right = _annotations.folded(node->right());
+  if ((node->is_typed(cdk::TYPE_INT) && is(right, 1))
+      || (node->left()->is_typed(cdk::TYPE_DOUBLE) && is(right, 1.0))) {
+    simplify(node, node->left());
+  }
+}
+
+void til::constant_folder::do_mod_node(cdk::mod_node * const node, int lvl) {
+  processArithmetic(node, lvl,
+                    [](long long a, long long b, long long &r) {
+                      if (b == 0 || (a == INT_MIN && b == -1)) return false; // traps at run time
+                      r = a % b;
+                      return true;
+                    },
+                    [](double a, double b, double &r) { return false; });
+}
+
+//---------------------------------------------------------------------------
+
+// int operands are compared as doubles: every int converts exactly
+void til::constant_folder::processComparison(cdk::binary_operation_node *const node, int lvl,
+                                             const std::function<bool(double, double)> &compare) {
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+
+  auto left = _annotations.folded(node->left()), right = _annotations.folded(node->right());
+  if (left != nullptr && right != nullptr) {
+    fold(node, compare(real(*left), real(*right)) ? 1 : 0);
+  }
+}
+
+void til::constant_folder::do_lt_node(cdk::lt_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a < b; });
+}
+void til::constant_folder::do_le_node(cdk::le_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a <= b; });
+}
+void til::constant_folder::do_ge_node(cdk::ge_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a >= b; });
+}
+void til::constant_folder::do_gt_node(cdk::gt_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a > b; });
+}
+void til::constant_folder::do_ne_node(cdk::ne_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a != b; });
+}
+void til::constant_folder::do_eq_node(cdk::eq_node * const node, int lvl) {
+  processComparison(node, lvl, [](double a, double b) { return a == b; });
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_variable_node(cdk::variable_node * const node, int lvl) {
+  // EMPTY
+}
+
+void til::constant_folder::do_rvalue_node(cdk::rvalue_node * const node, int lvl) {
+  node->lvalue()->accept(this, lvl + 2);
+}
+
+void til::constant_folder::do_assignment_node(cdk::assignment_node * const node, int lvl) {
+  node->lvalue()->accept(this, lvl + 2);
+  node->rvalue()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_program_node(til::program_node * const node, int lvl) {
+  node->statements()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_evaluation_node(til::evaluation_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+}
+
+void til::constant_folder::do_print_node(til::print_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_read_node(til::read_node * const node, int lvl) {
+  // EMPTY
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_loop_node(til::loop_node * const node, int lvl) {
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_if_node(til::if_node * const node, int lvl) {
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+void til::constant_folder::do_if_else_node(til::if_else_node * const node, int lvl) {
+  node->condition()->accept(this, lvl + 2);
+  node->thenblock()->accept(this, lvl + 2);
+  node->elseblock()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_declaration_node(til::declaration_node * const node, int lvl) {
+  if (node->initialValue() != nullptr) {
+    node->initialValue()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_function_call_node(til::function_call_node * const node, int lvl) {
+  if (node->identifier() != nullptr) {
+    node->identifier()->accept(this, lvl + 2);
+  }
+  node->arguments()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_function_node(til::function_node * const node, int lvl) {
+  node->block()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_return_node(til::return_node * const node, int lvl) {
+  if (node->value() != nullptr) {
+    node->value()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_next_node(til::next_node * const node, int lvl) {
+  // EMPTY
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_stop_node(til::stop_node * const node, int lvl) {
+  // EMPTY
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_block_node(til::block_node * const node, int lvl) {
+  node->declarations()->accept(this, lvl + 2);
+  node->instructions()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+// the expression is not evaluated: only its type matters
+void til::constant_folder::do_sizeof_node(til::sizeof_node * const node, int lvl) {
+  fold(node, static_cast<int>(node->expression()->type()->size()));
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_objects_node(til::objects_node * const node, int lvl) {
+  node->argument()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_null_ptr_node(til::null_ptr_node * const node, int lvl) {
+  // EMPTY
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_ptr_index_node(til::ptr_index_node * const node, int lvl) {
+  node->base()->accept(this, lvl + 2);
+  node->index()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::constant_folder::do_address_of_node(til::address_of_node * const node, int lvl) {
+  node->lvalue()->accept(this, lvl + 2);
+}
@@ -0,0 +1,63 @@
+#ifndef __TIL_TARGETS_CONSTANT_FOLDER_H__
+#define __TIL_TARGETS_CONSTANT_FOLDER_H__
+
+#include <functional>
+#include "targets/basic_ast_visitor.h"
+#include "targets/annotations.h"
+
+namespace til {
+
+  /**
+   * Folding pass, between typing and code generation: record the value of
+   * every expression computed from literals alone (with the promotions and
+   * the run-time semantics of the postfix code: 32-bit wrap-around, "&&"
+   * and "||" combining their operands bitwise), and a simpler equivalent
+   * for identities such as x+0, x*1 and, when x has no side effects, x*0.
+   * Divisions by zero and results that are not finite are left to run time.
+   */
+  class constant_folder: public basic_ast_visitor {
+    til::annotations &_annotations;
+    size_t _folded = 0;
+    size_t _simplified = 0;
+
+  public:
+    constant_folder(std::shared_ptr<cdk::compiler> compiler, til::annotations &annotations) :
+        basic_ast_visitor(compiler), _annotations(annotations) {
+    }
+
+  public:
+    ~constant_folder() {
+      // EMPTY
+    }
+
+  public:
+    /** Expressions replaced by their value. */
+    size_t folded() const {
+      return _folded;
+    }
+    /** Expressions replaced by one of their operands. */
+    size_t simplified() const {
+      return _simplified;
+    }
+
+  protected:
+    void fold(cdk::expression_node *const node, til::annotations::constant value);
+    void simplify(cdk::expression_node *const node, cdk::expression_node *const equivalent);
+    void processArithmetic(cdk::binary_operation_node *const node, int lvl,
+                           const std::function<bool(long long, long long, long long&)> &integer,
+                           const std::function<bool(double, double, double&)> &real);
+    void processComparison(cdk::binary_operation_node *const node, int lvl,
+                           const std::function<bool(double, double)> &compare);
+
+  public:
+    // do not edit these lines
+#define __IN_VISITOR_HEADER__
+#include ".auto/visitor_decls.h"       // automatically generated
+#undef __IN_VISITOR_HEADER__
+    // do not edit these lines: end
+
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,69 @@
+#include "targets/declaration_stream.h"
+#include "options.h"
+#include "timings.h"
+
+til::declaration_stream til::declaration_stream::_self;
+
+til::declaration_stream::declaration_stream() :
+    _streaming(options::instance().stream()), _cache(options::instance().cache()) {
+  // released declarations must not leave their types and strings behind; the
+  // first one starts where the arena is now, before anything is parsed
+  if (_streaming) {
+    til::arena::instance().destroy_nodes();
+    _start = til::arena::instance().mark();
+  }
+}
+
+til::code_generator &til::declaration_stream::generator(std::shared_ptr<cdk::compiler> compiler) {
+  if (!_generator) {
+    _generator = std::make_unique<code_generator>(compiler, _annotations, _cache, options::instance().jobs(),
+                                                  options::instance().peephole(), options::instance().ir());
+  }
+  return *_generator;
+}
+
+//---------------------------------------------------------------------------
+
+cdk::sequence_node *til::declaration_stream::first(std::shared_ptr<cdk::compiler> compiler, int lineno,
+                                                   cdk::basic_node *declaration) {
+  if (!_streaming) {
+    return til::arena::instance().node<cdk::sequence_node>(lineno, declaration);
+  }
+
+  // the sequence stays empty (until the program is added), so it is not released with the declarations
+  compile(compiler, declaration);
+  auto declarations = til::arena::instance().node<cdk::sequence_node>(lineno);
+  _start = til::arena::instance().mark();
+  return declarations;
+}
+
+void til::declaration_stream::next(std::shared_ptr<cdk::compiler> compiler, cdk::sequence_node *declarations,
+                                   cdk::basic_node *declaration) {
+  if (!_streaming) {
+    declarations->nodes().push_back(declaration);
+    return;
+  }
+  compile(compiler, declaration);
+}
+
+// declarations are written in batches of one per job, so that they can still be written in parallel
+void til::declaration_stream::compile(std::shared_ptr<cdk::compiler> compiler, cdk::basic_node *declaration) {
+  til::timings::pause pause; // checking and code generation are not parsing
+  code_generator &g = generator(compiler);
+  _declarations++;
+  {
+    til::timings::probe probe(til::timings::CHECK);
+    if (!g.add(declaration)) _ok = false;
+  }
+
+  // after an error, declarations are still checked, but no code is written
+  if (!_ok) {
+    g.discard();
+  } else if (g.pending() >= options::instance().jobs()) {
+    g.flush(_code);
+  }
+
+  if (g.pending() == 0) {
+    til::arena::instance().release(_start);
+  }
+}
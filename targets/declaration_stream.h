@@ -0,0 +1,83 @@
+#ifndef __TIL_TARGETS_DECLARATION_STREAM_H__
+#define __TIL_TARGETS_DECLARATION_STREAM_H__
+
+#include <memory>
+#include <cdk/compiler.h>
+#include <cdk/ast/basic_node.h>
+#include <cdk/ast/sequence_node.h>
+#include "arena.h"
+#include "targets/annotations.h"
+#include "targets/code_generator.h"
+#include "targets/compile_cache.h"
+#include "targets/postfix_buffer.h"
+
+namespace til {
+
+  /**
+   * Top-level declarations on their way from the parser to the postfix
+   * target. By default they are collected in the file's sequence, as
+   * usual. In streaming mode (TIL_STREAM), each complete declaration is
+   * typed and its code generated right away, and its nodes are released
+   * from the arena: only the program is left in the tree. Either way, the
+   * target finishes the compilation with generator() and code().
+   */
+  class declaration_stream {
+    static declaration_stream _self;
+
+    bool _streaming;
+    til::annotations _annotations;
+    til::compile_cache _cache;
+    std::unique_ptr<code_generator> _generator;
+    til::postfix_buffer _code;     // code of the declarations streamed so far
+    til::arena::position _start;   // first node not yet compiled
+    size_t _declarations = 0;      // declarations streamed so far
+    bool _ok = true;
+
+  private:
+    declaration_stream();
+
+  public:
+    static declaration_stream &instance() {
+      return _self;
+    }
+
+    bool streaming() const {
+      return _streaming;
+    }
+    size_t declarations() const {
+      return _declarations;
+    }
+
+    /** Whether the declarations streamed so far were free of errors. */
+    bool ok() const {
+      return _ok;
+    }
+
+    /** The sequence of top-level declarations, starting with the first one. */
+    cdk::sequence_node *first(std::shared_ptr<cdk::compiler> compiler, int lineno, cdk::basic_node *declaration);
+
+    /** Another top-level declaration. */
+    void next(std::shared_ptr<cdk::compiler> compiler, cdk::sequence_node *declarations, cdk::basic_node *declaration);
+
+    /** The code generator of the compilation (with the declarations seen so far). */
+    code_generator &generator(std::shared_ptr<cdk::compiler> compiler);
+
+    /** Drop the code generator (and its hold on the compiler) at the end of the compilation. */
+    void finish() {
+      _generator.reset();
+    }
+
+    til::postfix_buffer &code() {
+      return _code;
+    }
+    til::compile_cache &cache() {
+      return _cache;
+    }
+
+  private:
+    void compile(std::shared_ptr<cdk::compiler> compiler, cdk::basic_node *declaration);
+  };
+
+} // til
+
+#endif
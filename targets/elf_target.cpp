@@ -0,0 +1,7 @@
+#include "targets/elf_target.h"
+
+/**
+ * ELF32 objects for ix86.
+ * @var create and register an evaluator for ELF targets.
+ */
+til::elf_target til::elf_target::_self;
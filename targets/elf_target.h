@@ -0,0 +1,67 @@
+#ifndef __TIL_TARGETS_ELF_TARGET_H__
+#define __TIL_TARGETS_ELF_TARGET_H__
+
+#include <cdk/targets/basic_target.h>
+#include <cdk/ast/basic_node.h>
+#include "arena.h"
+#include "interner.h"
+#include "timings.h"
+#include "targets/code_generator.h"
+#include "targets/declaration_stream.h"
+#include "targets/elf_writer.h"
+
+namespace til {
+
+  /**
+   * The postfix code of the asm target, assembled by the compiler itself
+   * into an ELF32 object (see elf_writer), ready for "ld -m elf_i386" with
+   * the runtime: no assembly text is written, and no assembler is run.
+   */
+  class elf_target: public cdk::basic_target {
+    static elf_target _self;
+
+  private:
+    elf_target() :
+        cdk::basic_target("elf") {
+    }
+
+  public:
+    bool evaluate(std::shared_ptr<cdk::compiler> compiler) {
+      til::timings::instance().parsed();
+
+      til::declaration_stream &stream = til::declaration_stream::instance();
+      code_generator &generator = stream.generator(compiler);
+      if (!stream.ok() || !generator.annotate(compiler->ast())) return false;
+
+      postfix_buffer &code = stream.code();
+      generator.generate(code);
+      if (compiler->debug()) {
+        generator.report(std::cerr);
+      }
+      stream.finish();
+
+      size_t bytes;
+      {
+        til::timings::probe probe(til::timings::EMIT);
+        elf_writer writer;
+        writer.assemble(code);
+        bytes = writer.write(*compiler->ostream());
+      }
+
+      stream.cache().report(std::cerr); // only when the cache is in use
+      if (compiler->debug()) {
+        til::arena::instance().report(std::cerr);
+        til::interner::instance().report(std::cerr);
+        std::cerr << "elf: " << bytes << " bytes" << std::endl;
+      }
+
+      til::timings::instance().save();
+
+      return true;
+    }
+
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,370 @@
+#include <cstring>
+#include "targets/elf_writer.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using opcode = til::postfix_buffer::opcode;
+
+  bool byte(int value) {
+    return value >= -128 && value <= 127;
+  }
+
+  // second byte of SETcc and of the near Jcc (after 0x0f) for a comparison of the second value with the top one
+  uint8_t condition(opcode op) {
+    switch (op) {
+      case opcode::EQ: case opcode::JEQ: return 0x04;
+      case opcode::NE: case opcode::JNE: return 0x05;
+      case opcode::LT: case opcode::JLT: return 0x0c;
+      case opcode::LE: case opcode::JLE: return 0x0e;
+      case opcode::GT: case opcode::JGT: return 0x0f;
+      case opcode::GE: case opcode::JGE: return 0x0d;
+      default: return 0;
+    }
+  }
+
+  // ELF32 (System V ABI, i386 supplement)
+  enum { SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_NOBITS = 8, SHT_REL = 9 };
+  enum { SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4 };
+  enum { STB_LOCAL = 0, STB_GLOBAL = 1, STT_NOTYPE = 0, STT_OBJECT = 1, STT_FUNC = 2 };
+  enum { R_386_32 = 1, R_386_PC32 = 2 };
+
+  struct buffer : std::vector<uint8_t> {
+    void u8(uint8_t v) {
+      push_back(v);
+    }
+    void u16(uint16_t v) {
+      u8(v & 0xff);
+      u8(v >> 8);
+    }
+    void u32(uint32_t v) {
+      u16(v & 0xffff);
+      u16(v >> 16);
+    }
+    void pad(size_t boundary) {
+      while (size() % boundary != 0) u8(0);
+    }
+  };
+
+  // names in a string table
+  struct strings : buffer {
+    strings() {
+      u8(0);
+    }
+    uint32_t add(const std::string &name) {
+      uint32_t offset = static_cast<uint32_t>(size());
+      insert(end(), name.begin(), name.end());
+      u8(0);
+      return offset;
+    }
+  };
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+void til::elf_writer::assemble(const postfix_buffer &code) {
+  for (const postfix_buffer::instruction &ins : code.code()) {
+    assemble(ins);
+  }
+}
+
+void til::elf_writer::code(std::initializer_list<uint8_t> bytes) {
+  _bytes[_section].insert(_bytes[_section].end(), bytes);
+}
+
+void til::elf_writer::word(uint32_t value) {
+  for (int k = 0; k < 4; k++) {
+    _bytes[_section].push_back(static_cast<uint8_t>(value >> (8 * k)));
+  }
+}
+
+// 4 bytes with the address of a label, set by the linker
+void til::elf_writer::address(const std::string &label) {
+  _relocations[_section].push_back({static_cast<uint32_t>(_bytes[_section].size()), label, false});
+  _symbols[label]; // declared, if not yet defined
+  word(0);
+}
+
+// an instruction with a rel32 operand (jmp, jcc, call)
+void til::elf_writer::jump(std::initializer_list<uint8_t> opcode, const std::string &label) {
+  code(opcode);
+  _jumps.push_back({static_cast<uint32_t>(_bytes[TEXT].size()), label, true});
+  _symbols[label];
+  word(0);
+}
+
+// add (0) or sub (5) bytes to or from esp
+void til::elf_writer::esp(uint8_t operation, int bytes) {
+  uint8_t modrm = 0xc4 | (operation << 3);
+  if (byte(bytes)) {
+    code({0x83, modrm, static_cast<uint8_t>(bytes)});
+  } else {
+    code({0x81, modrm});
+    word(bytes);
+  }
+}
+
+void til::elf_writer::align(size_t boundary) {
+  while (_bytes[_section].size() % boundary != 0) {
+    _bytes[_section].push_back(_section == TEXT ? 0x90 : 0); // nop
+  }
+}
+
+// the sequences of the postfix machine: the top of the stack is at [esp], the value
+// below it at [esp+4] (an int) or [esp+8] (a double); eax and ecx are scratch
+void til::elf_writer::assemble(const postfix_buffer::instruction &ins) {
+  switch (ins.op) {
+    case opcode::TEXT: _section = TEXT; break;
+    case opcode::RODATA: _section = RODATA; break;
+    case opcode::DATA: _section = DATA; break;
+    case opcode::BSS: _section = BSS; break;
+    case opcode::ALIGN: align(4); break;
+    case opcode::LABEL: {
+      symbol &s = _symbols[ins.s];
+      s.section = _section;
+      s.value = static_cast<uint32_t>(_bytes[_section].size());
+      break;
+    }
+    case opcode::GLOBAL:
+      _symbols[ins.s].global = true;
+      _symbols[ins.s].function = ins.i == postfix_buffer::KIND_FUNC;
+      break;
+    case opcode::EXTERN: _symbols[ins.s].global = true; break;
+
+    case opcode::SINT: word(ins.i); break;
+    case opcode::SDOUBLE: {
+      uint64_t bits;
+      std::memcpy(&bits, &ins.d, sizeof(bits));
+      word(static_cast<uint32_t>(bits));
+      word(static_cast<uint32_t>(bits >> 32));
+      break;
+    }
+    case opcode::SSTRING:
+      _bytes[_section].insert(_bytes[_section].end(), ins.s.begin(), ins.s.end());
+      _bytes[_section].push_back(0);
+      break;
+    case opcode::SADDR: address(ins.s); break;
+    case opcode::SALLOC: _bytes[_section].resize(_bytes[_section].size() + ins.i); break;
+
+    case opcode::INT:
+      if (byte(ins.i)) code({0x6a, static_cast<uint8_t>(ins.i)}); // push imm8
+      else {
+        code({0x68}); // push imm32
+        word(ins.i);
+      }
+      break;
+    case opcode::DOUBLE: {
+      uint64_t bits;
+      std::memcpy(&bits, &ins.d, sizeof(bits));
+      code({0x68}); // push the high half, then the low one
+      word(static_cast<uint32_t>(bits >> 32));
+      code({0x68});
+      word(static_cast<uint32_t>(bits));
+      break;
+    }
+    case opcode::ADDR:
+      code({0x68});
+      address(ins.s);
+      break;
+    case opcode::LOCAL:
+      if (byte(ins.i)) code({0x8d, 0x45, static_cast<uint8_t>(ins.i)}); // lea eax, [ebp+disp8]
+      else {
+        code({0x8d, 0x85}); // lea eax, [ebp+disp32]
+        word(ins.i);
+      }
+      code({0x50}); // push eax
+      break;
+    case opcode::SP: code({0x54}); break; // push esp
+    case opcode::ALLOC: code({0x58, 0x29, 0xc4}); break; // pop eax; sub esp, eax
+
+    case opcode::LDINT: code({0x58, 0xff, 0x30}); break; // pop eax; push dword [eax]
+    case opcode::LDDOUBLE: code({0x58, 0xff, 0x70, 0x04, 0xff, 0x30}); break; // ...; push dword [eax+4]; push dword [eax]
+    case opcode::STINT: code({0x59, 0x58, 0x89, 0x01}); break; // pop ecx; pop eax; mov [ecx], eax
+    case opcode::STDOUBLE: code({0x59, 0x58, 0x89, 0x01, 0x58, 0x89, 0x41, 0x04}); break; // ...; pop eax; mov [ecx+4], eax
+    case opcode::DUP32: code({0xff, 0x34, 0x24}); break; // push dword [esp]
+    case opcode::DUP64: code({0xff, 0x74, 0x24, 0x04, 0xff, 0x74, 0x24, 0x04}); break; // push dword [esp+4], twice
+    case opcode::TRASH: esp(0, ins.i); break;
+
+    // pop eax; <op> [esp], eax
+    case opcode::ADD: code({0x58, 0x01, 0x04, 0x24}); break;
+    case opcode::SUB: code({0x58, 0x29, 0x04, 0x24}); break;
+    case opcode::AND: code({0x58, 0x21, 0x04, 0x24}); break;
+    case opcode::OR: code({0x58, 0x09, 0x04, 0x24}); break;
+    case opcode::MUL: code({0x58, 0x0f, 0xaf, 0x04, 0x24, 0x89, 0x04, 0x24}); break; // imul eax, [esp]; mov [esp], eax
+    case opcode::DIV: code({0x59, 0x58, 0x99, 0xf7, 0xf9, 0x50}); break; // pop ecx; pop eax; cdq; idiv ecx; push eax
+    case opcode::MOD: code({0x59, 0x58, 0x99, 0xf7, 0xf9, 0x52}); break; // ...; push edx
+    case opcode::NEG: code({0xf7, 0x1c, 0x24}); break; // neg dword [esp]
+
+    // pop eax; xor ecx, ecx; cmp [esp], eax; setcc cl; mov [esp], ecx
+    case opcode::EQ:
+    case opcode::NE:
+    case opcode::LT:
+    case opcode::LE:
+    case opcode::GT:
+    case opcode::GE:
+      code({0x58, 0x31, 0xc9, 0x39, 0x04, 0x24, 0x0f, static_cast<uint8_t>(0x90 | condition(ins.op)), 0xc1, 0x89, 0x0c, 0x24});
+      break;
+
+    // fld qword [esp+8]; f<op> qword [esp]; add esp, 8; fstp qword [esp]
+    case opcode::DADD: code({0xdd, 0x44, 0x24, 0x08, 0xdc, 0x04, 0x24, 0x83, 0xc4, 0x08, 0xdd, 0x1c, 0x24}); break;
+    case opcode::DSUB: code({0xdd, 0x44, 0x24, 0x08, 0xdc, 0x24, 0x24, 0x83, 0xc4, 0x08, 0xdd, 0x1c, 0x24}); break;
+    case opcode::DMUL: code({0xdd, 0x44, 0x24, 0x08, 0xdc, 0x0c, 0x24, 0x83, 0xc4, 0x08, 0xdd, 0x1c, 0x24}); break;
+    case opcode::DDIV: code({0xdd, 0x44, 0x24, 0x08, 0xdc, 0x34, 0x24, 0x83, 0xc4, 0x08, 0xdd, 0x1c, 0x24}); break;
+    case opcode::DNEG: code({0xdd, 0x04, 0x24, 0xd9, 0xe0, 0xdd, 0x1c, 0x24}); break; // fld; fchs; fstp
+    case opcode::I2D: code({0xdb, 0x04, 0x24, 0x83, 0xec, 0x04, 0xdd, 0x1c, 0x24}); break; // fild dword [esp]; sub esp, 4; fstp
+    case opcode::DCMP:
+      // -1, 0 or 1: fld [esp]; fld [esp+8]; fcomip st1; fstp st0; seta al; setb cl; (al - cl) to the int on top
+      code({0xdd, 0x04, 0x24, 0xdd, 0x44, 0x24, 0x08, 0xdf, 0xf1, 0xdd, 0xd8, 0x0f, 0x97, 0xc0, 0x0f, 0x92, 0xc1,
+            0x0f, 0xb6, 0xc0, 0x0f, 0xb6, 0xc9, 0x29, 0xc8, 0x83, 0xc4, 0x0c, 0x89, 0x04, 0x24});
+      break;
+
+    case opcode::JMP: jump({0xe9}, ins.s); break;
+    case opcode::JZ: code({0x58, 0x85, 0xc0}); jump({0x0f, 0x84}, ins.s); break; // pop eax; test eax, eax; jz
+    case opcode::JNZ: code({0x58, 0x85, 0xc0}); jump({0x0f, 0x85}, ins.s); break;
+    case opcode::JEQ:
+    case opcode::JNE:
+    case opcode::JLT:
+    case opcode::JLE:
+    case opcode::JGT:
+    case opcode::JGE:
+      code({0x58, 0x59, 0x39, 0xc1}); // pop eax; pop ecx; cmp ecx, eax
+      jump({0x0f, static_cast<uint8_t>(0x80 | condition(ins.op))}, ins.s);
+      break;
+    case opcode::CALL: jump({0xe8}, ins.s); break;
+    case opcode::BRANCH: code({0x58, 0xff, 0xd0}); break; // pop eax; call eax
+    case opcode::ENTER:
+      code({0x55, 0x89, 0xe5}); // push ebp; mov ebp, esp
+      if (ins.i > 0) esp(5, ins.i);
+      break;
+    case opcode::LEAVE: code({0xc9}); break;
+    case opcode::RET: code({0xc3}); break;
+    case opcode::STFVAL32: code({0x58}); break; // pop eax
+    case opcode::STFVAL64: code({0xdd, 0x04, 0x24, 0x83, 0xc4, 0x08}); break; // fld qword [esp]; add esp, 8
+    case opcode::LDFVAL32: code({0x50}); break; // push eax
+    case opcode::LDFVAL64: code({0x83, 0xec, 0x08, 0xdd, 0x1c, 0x24}); break; // sub esp, 8; fstp qword [esp]
+  }
+}
+
+//---------------------------------------------------------------------------
+
+size_t til::elf_writer::write(std::ostream &os) {
+  // jumps and calls to labels of .text are resolved; the others (to labels of other
+  // objects) are relative relocations, with the -4 of the rel32 operand in place
+  for (const relocation &j : _jumps) {
+    const symbol &s = _symbols[j.symbol];
+    int32_t rel = -4;
+    if (s.section == TEXT) {
+      rel = static_cast<int32_t>(s.value) - static_cast<int32_t>(j.offset + 4);
+    } else {
+      _relocations[TEXT].push_back(j);
+    }
+    std::memcpy(&_bytes[TEXT][j.offset], &rel, sizeof(rel));
+  }
+  _jumps.clear();
+
+  // local symbols first, then the global ones (defined here or not)
+  enum { NUL, SEC_TEXT, SEC_RODATA, SEC_DATA, SEC_BSS, REL_TEXT, REL_RODATA, REL_DATA, SYMTAB, STRTAB, SHSTRTAB, NOTE, COUNT };
+  strings names;
+  buffer symtab;
+  std::map<std::string, uint32_t> index;
+  symtab.resize(16); // the null symbol
+  uint32_t locals = 1;
+  for (int pass = 0; pass < 2; pass++) {
+    for (auto &[name, s] : _symbols) {
+      bool global = s.global || s.section < 0;
+      if (global != (pass == 1)) continue;
+      index[name] = static_cast<uint32_t>(symtab.size() / 16);
+      symtab.u32(names.add(name));
+      symtab.u32(s.value);
+      symtab.u32(0);
+      uint8_t type = s.function ? STT_FUNC : global && s.section >= 0 ? STT_OBJECT : STT_NOTYPE;
+      symtab.u8(static_cast<uint8_t>(((global ? STB_GLOBAL : STB_LOCAL) << 4) | type));
+      symtab.u8(0);
+      symtab.u16(static_cast<uint16_t>(s.section < 0 ? 0 : SEC_TEXT + s.section));
+    }
+    if (pass == 0) locals = static_cast<uint32_t>(symtab.size() / 16);
+  }
+
+  buffer rels[3];
+  for (int k = TEXT; k <= DATA; k++) {
+    for (const relocation &r : _relocations[k]) {
+      rels[k].u32(r.offset);
+      rels[k].u32((index[r.symbol] << 8) | (r.relative ? R_386_PC32 : R_386_32));
+    }
+  }
+
+  struct header {
+    const char *name;
+    uint32_t type, flags;
+    const std::vector<uint8_t> *contents;
+    uint32_t size, link, info, align, entsize;
+  };
+  strings shnames;
+  std::vector<header> sections(COUNT);
+  sections[NUL] = {"", 0, 0, nullptr, 0, 0, 0, 0, 0};
+  sections[SEC_TEXT] = {".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, &_bytes[TEXT], 0, 0, 0, 16, 0};
+  sections[SEC_RODATA] = {".rodata", SHT_PROGBITS, SHF_ALLOC, &_bytes[RODATA], 0, 0, 0, 4, 0};
+  sections[SEC_DATA] = {".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, &_bytes[DATA], 0, 0, 0, 4, 0};
+  sections[SEC_BSS] = {".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, nullptr, static_cast<uint32_t>(_bytes[BSS].size()), 0, 0, 4, 0};
+  sections[REL_TEXT] = {".rel.text", SHT_REL, 0, &rels[TEXT], 0, SYMTAB, SEC_TEXT, 4, 8};
+  sections[REL_RODATA] = {".rel.rodata", SHT_REL, 0, &rels[RODATA], 0, SYMTAB, SEC_RODATA, 4, 8};
+  sections[REL_DATA] = {".rel.data", SHT_REL, 0, &rels[DATA], 0, SYMTAB, SEC_DATA, 4, 8};
+  sections[SYMTAB] = {".symtab", SHT_SYMTAB, 0, &symtab, 0, STRTAB, locals, 4, 16};
+  sections[STRTAB] = {".strtab", SHT_STRTAB, 0, &names, 0, 0, 0, 1, 0};
+  sections[SHSTRTAB] = {".shstrtab", SHT_STRTAB, 0, &shnames, 0, 0, 0, 1, 0};
+  sections[NOTE] = {".note.GNU-stack", SHT_PROGBITS, 0, nullptr, 0, 0, 0, 1, 0}; // no executable stack
+  std::vector<uint32_t> name(COUNT);
+  for (int k = 0; k < COUNT; k++) {
+    name[k] = k == NUL ? 0 : shnames.add(sections[k].name);
+  }
+
+  // ELF header, contents of the sections, section headers
+  buffer out;
+  out.insert(out.end(), {0x7f, 'E', 'L', 'F', 1 /* 32 bits */, 1 /* little-endian */, 1 /* version */});
+  out.pad(16);
+  out.u16(1);  // relocatable
+  out.u16(3);  // i386
+  out.u32(1);  // version
+  out.u32(0);  // entry
+  out.u32(0);  // program headers
+  size_t shoff = out.size();
+  out.u32(0);  // section headers, set below
+  out.u32(0);  // flags
+  out.u16(52); // header size
+  out.u16(0);
+  out.u16(0);
+  out.u16(40); // section header size
+  out.u16(COUNT);
+  out.u16(SHSTRTAB);
+
+  std::vector<uint32_t> offset(COUNT, 0);
+  for (int k = 1; k < COUNT; k++) {
+    out.pad(16);
+    offset[k] = static_cast<uint32_t>(out.size());
+    if (sections[k].contents) {
+      sections[k].size = static_cast<uint32_t>(sections[k].contents->size());
+      out.insert(out.end(), sections[k].contents->begin(), sections[k].contents->end());
+    }
+  }
+  out.pad(4);
+  uint32_t headers = static_cast<uint32_t>(out.size());
+  std::memcpy(&out[shoff], &headers, sizeof(headers));
+  for (int k = 0; k < COUNT; k++) {
+    const header &h = sections[k];
+    out.u32(name[k]);
+    out.u32(h.type);
+    out.u32(h.flags);
+    out.u32(0);
+    out.u32(offset[k]);
+    out.u32(h.size);
+    out.u32(h.link);
+    out.u32(h.info);
+    out.u32(h.align);
+    out.u32(h.entsize);
+  }
+
+  os.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+  return out.size();
+}
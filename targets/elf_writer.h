@@ -0,0 +1,65 @@
+#ifndef __TIL_TARGETS_ELF_WRITER_H__
+#define __TIL_TARGETS_ELF_WRITER_H__
+
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "targets/postfix_buffer.h"
+
+namespace til {
+
+  /**
+   * Assembler of postfix code straight into an ELF32 relocatable object
+   * for i386, with no assembly text in between. Each instruction becomes
+   * the machine code of the ix86 postfix machine (doubles in the x87 unit,
+   * as the emitter does) in .text; data goes to .rodata, .data and .bss.
+   * Jumps and calls to labels of the object are resolved here; calls to
+   * other functions (EXTERN, such as the runtime's) and every address
+   * (ADDR, SADDR) are left to the linker as relocations. GLOBAL labels
+   * become global symbols, the others local ones.
+   */
+  class elf_writer {
+    enum section_index { TEXT, RODATA, DATA, BSS, SECTIONS };
+
+    struct symbol {
+      int section = -1;          // -1: not defined here
+      uint32_t value = 0;        // offset in its section
+      bool global = false;
+      bool function = false;
+    };
+
+    struct relocation {
+      uint32_t offset;
+      std::string symbol;
+      bool relative;             // R_386_PC32 (else R_386_32)
+    };
+
+    std::vector<uint8_t> _bytes[SECTIONS]; // of .bss, only the size counts
+    std::vector<relocation> _relocations[SECTIONS];
+    std::vector<relocation> _jumps;        // rel32 in .text, to resolve when every label is known
+    std::map<std::string, symbol> _symbols;
+    int _section = TEXT;
+
+  public:
+    /** Assemble the code (the EXTERN declarations included) after what was assembled so far. */
+    void assemble(const postfix_buffer &code);
+
+    /** Write the object. @return its size in bytes */
+    size_t write(std::ostream &os);
+
+  private:
+    void assemble(const postfix_buffer::instruction &ins);
+    void code(std::initializer_list<uint8_t> bytes);
+    void word(uint32_t value);
+    void address(const std::string &label);
+    void jump(std::initializer_list<uint8_t> opcode, const std::string &label);
+    void esp(uint8_t operation, int bytes);
+    void align(size_t boundary);
+  };
+
+} // til
+
+#endif
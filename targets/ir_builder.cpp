@@ -0,0 +1,690 @@
+#include <algorithm>
+#include <cstdint>
+#include "targets/ir_builder.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+#include "til_parser.tab.h"
+
+//---------------------------------------------------------------------------
+
+til::ir::type til::ir_builder::type(std::shared_ptr<cdk::basic_type> t) {
+  if (t == nullptr) throw ir::unsupported{"untyped value"};
+  switch (t->name()) {
+    case cdk::TYPE_INT: return ir::type::INT;
+    case cdk::TYPE_DOUBLE: return ir::type::DOUBLE;
+    case cdk::TYPE_STRING: return ir::type::POINTER;
+    case cdk::TYPE_POINTER: return ir::type::POINTER;
+    case cdk::TYPE_FUNCTIONAL: return ir::type::FUNCTION;
+    case cdk::TYPE_VOID: return ir::type::VOID;
+    default: throw ir::unsupported{"untyped value"};
+  }
+}
+
+// only nodes seen by the typing pass are lowered: synthesized ones are left to the postfix writer
+std::shared_ptr<til::symbol> til::ir_builder::symbol(cdk::basic_node *const node) const {
+  auto symbol = _annotations.symbol(node);
+  if (symbol == nullptr) throw ir::unsupported{"node without a symbol"};
+  return symbol;
+}
+
+til::ir::instruction *til::ir_builder::append(ir::op code, ir::type t, const std::vector<ir::instruction*> &operands) {
+  return _context.function->append(_context.block, code, t, operands);
+}
+
+til::ir::instruction *til::ir_builder::constant(int i) {
+  ir::instruction *ins = append(ir::op::CONST, ir::type::INT);
+  ins->i = i;
+  return ins;
+}
+
+// blocks are laid out in the order they are started, which is the order of the source
+til::ir::block *til::ir_builder::start(ir::block *b) {
+  _context.function->place(b);
+  return _context.block = b;
+}
+
+void til::ir_builder::jump(ir::block *to) {
+  if (_context.block->terminator() == nullptr) {
+    append(ir::op::JUMP, ir::type::VOID)->targets = {to};
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// the value found by the folding pass, or that of the simpler equivalent it found
+til::ir::instruction *til::ir_builder::value(cdk::expression_node *const node, int lvl) {
+  if (auto folded = _annotations.folded(node)) {
+    if (std::holds_alternative<double>(*folded)) {
+      ir::instruction *ins = append(ir::op::CONST, ir::type::DOUBLE);
+      ins->d = std::get<double>(*folded);
+      return ins;
+    }
+    return constant(std::get<int>(*folded));
+  }
+  if (auto equivalent = _annotations.simplified(node)) {
+    return value(equivalent, lvl);
+  }
+
+  _value = nullptr;
+  _external = nullptr;
+  node->accept(this, lvl);
+  if (_value == nullptr) throw ir::unsupported{"function used as a value"};
+  return _value;
+}
+
+// @return the address of the lvalue, or nullptr for external functions (named by _external)
+til::ir::instruction *til::ir_builder::address(cdk::lvalue_node *const node, int lvl) {
+  _value = nullptr;
+  _external = nullptr;
+  node->accept(this, lvl);
+  return _value;
+}
+
+til::ir::instruction *til::ir_builder::valueAndCast(std::shared_ptr<cdk::basic_type> const type, cdk::expression_node *const node,
+                                                    int lvl) {
+  if (node->is_typed(cdk::TYPE_FUNCTIONAL)) {
+    // the postfix writer wraps functions that need conversions in a new function
+    auto intended_type = cdk::functional_type::cast(type);
+    auto node_type = cdk::functional_type::cast(node->type());
+    if (intended_type->output(0)->name() == cdk::TYPE_DOUBLE && node_type->output(0)->name() == cdk::TYPE_INT) {
+      throw ir::unsupported{"function converted to another type"};
+    }
+    for (size_t i = 0; i < node_type->input()->size(); i++) {
+      if (intended_type->input(i)->name() == cdk::TYPE_DOUBLE && node_type->input(i)->name() == cdk::TYPE_INT) {
+        throw ir::unsupported{"function converted to another type"};
+      }
+    }
+    return value(node, lvl);
+  }
+
+  ir::instruction *v = value(node, lvl);
+  if (type->name() == cdk::TYPE_DOUBLE && node->is_typed(cdk::TYPE_INT)) {
+    v = append(ir::op::I2D, ir::type::DOUBLE, {v});
+  }
+  return v;
+}
+
+// offset*size (a pointer displacement): constant offsets are scaled here
+til::ir::instruction *til::ir_builder::scaled(cdk::expression_node *const offset, size_t size, int lvl) {
+  ir::instruction *v = value(offset, lvl);
+  if (v->code == ir::op::CONST) {
+    // a new constant: v may also be used elsewhere (the value of an assignment)
+    return constant(static_cast<int>(static_cast<uint32_t>(v->i) * static_cast<uint32_t>(size)));
+  }
+  return append(ir::op::MUL, ir::type::INT, {v, constant(size)});
+}
+
+// +, -, * and /: ints become doubles next to doubles, and are scaled next to pointers
+til::ir::instruction *til::ir_builder::arithmetic(cdk::binary_operation_node *const node, ir::op code, int lvl) {
+  auto operand = [&](cdk::expression_node *const side) {
+    if (side->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
+      auto ref = cdk::reference_type::cast(node->type());
+      return scaled(side, std::max(ref->referenced()->size(), static_cast<size_t>(1)), lvl);
+    }
+    ir::instruction *v = value(side, lvl);
+    if (side->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
+      v = append(ir::op::I2D, ir::type::DOUBLE, {v});
+    }
+    return v;
+  };
+
+  ir::instruction *left = operand(node->left());
+  ir::instruction *right = operand(node->right());
+  ir::instruction *result = append(code, type(node->type()), {left, right});
+
+  // the difference of two pointers counts elements
+  if (code == ir::op::SUB && node->left()->is_typed(cdk::TYPE_POINTER) && node->right()->is_typed(cdk::TYPE_POINTER)) {
+    auto ref = cdk::reference_type::cast(node->left()->type());
+    result = append(ir::op::DIV, ir::type::INT, {result, constant(std::max(static_cast<size_t>(1), ref->referenced()->size()))});
+  }
+  return result;
+}
+
+void til::ir_builder::comparison(cdk::binary_operation_node *const node, ir::cond cc, int lvl) {
+  ir::instruction *left = value(node->left(), lvl);
+  if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
+    left = append(ir::op::I2D, ir::type::DOUBLE, {left});
+  }
+  ir::instruction *right = value(node->right(), lvl);
+  if (node->left()->is_typed(cdk::TYPE_DOUBLE) && node->right()->is_typed(cdk::TYPE_INT)) {
+    right = append(ir::op::I2D, ir::type::DOUBLE, {right});
+  }
+  _value = append(ir::op::CMP, ir::type::INT, {left, right});
+  _value->cc = cc;
+}
+
+// the value of "&&" and "||": the left operand decides, or both are combined bitwise
+void til::ir_builder::logical(cdk::binary_operation_node *const node, bool conjunction, int lvl) {
+  ir::instruction *left = value(node->left(), lvl + 2);
+  ir::block *from = _context.block;
+  ir::instruction *test = append(ir::op::BRANCH, ir::type::VOID, {left});
+
+  ir::block *rest = start(_context.function->add_block());
+  ir::instruction *right = value(node->right(), lvl);
+  ir::instruction *combined = append(conjunction ? ir::op::AND : ir::op::OR, ir::type::INT, {left, right});
+  ir::block *end = _context.block;
+
+  ir::block *join = _context.function->add_block();
+  test->targets = conjunction ? std::vector<ir::block*>{rest, join} : std::vector<ir::block*>{join, rest};
+  jump(join);
+  start(join);
+  _value = append(ir::op::PHI, ir::type::INT, {left, combined});
+  _value->targets = {from, end};
+}
+
+// whether the value is always 0 or 1 (&& and || combine their operands bitwise)
+bool til::ir_builder::boolean(cdk::expression_node *const node) const {
+  if (auto value = _annotations.folded(node)) {
+    return std::holds_alternative<int>(*value) && (std::get<int>(*value) == 0 || std::get<int>(*value) == 1);
+  }
+  if (auto equivalent = _annotations.simplified(node)) {
+    return boolean(equivalent);
+  }
+  if (auto logical = dynamic_cast<cdk::and_node*>(node)) {
+    return boolean(logical->left()) && boolean(logical->right());
+  }
+  if (auto logical = dynamic_cast<cdk::or_node*>(node)) {
+    return boolean(logical->left()) && boolean(logical->right());
+  }
+  return dynamic_cast<cdk::not_node*>(node) || dynamic_cast<cdk::lt_node*>(node) || dynamic_cast<cdk::le_node*>(node)
+      || dynamic_cast<cdk::gt_node*>(node) || dynamic_cast<cdk::ge_node*>(node) || dynamic_cast<cdk::eq_node*>(node)
+      || dynamic_cast<cdk::ne_node*>(node);
+}
+
+// go to `yes' when the condition is true (nonzero), else to `no' (as the postfix writer's jumping code)
+void til::ir_builder::branch(cdk::expression_node *const condition, ir::block *yes, ir::block *no, int lvl) {
+  auto folded = _annotations.folded(condition);
+  if (folded != nullptr && std::holds_alternative<int>(*folded)) {
+    jump(std::get<int>(*folded) != 0 ? yes : no);
+    return;
+  }
+  if (auto equivalent = _annotations.simplified(condition)) {
+    branch(equivalent, yes, no, lvl);
+    return;
+  }
+
+  if (auto negation = dynamic_cast<cdk::not_node*>(condition)) {
+    branch(negation->argument(), no, yes, lvl);
+    return;
+  }
+
+  // short-circuit: only when the bitwise result is also the logical one
+  auto conjunction = dynamic_cast<cdk::and_node*>(condition);
+  auto disjunction = dynamic_cast<cdk::or_node*>(condition);
+  if ((conjunction || disjunction) && boolean(condition)) {
+    auto logical = dynamic_cast<cdk::binary_operation_node*>(condition);
+    ir::block *rest = _context.function->add_block();
+    if (conjunction) branch(logical->left(), rest, no, lvl + 2);
+    else branch(logical->left(), yes, rest, lvl + 2);
+    start(rest);
+    branch(logical->right(), yes, no, lvl + 2);
+    return;
+  }
+
+  ir::instruction *test = value(condition, lvl);
+  if (test->type == ir::type::DOUBLE) throw ir::unsupported{"double condition"};
+  append(ir::op::BRANCH, ir::type::VOID, {test})->targets = {yes, no};
+}
+
+void til::ir_builder::loopControl(int level, bool next) {
+  if (level <= 0 || _context.loops.size() < static_cast<size_t>(level)) {
+    throw ir::unsupported{"invalid loop level"}; // reported by the postfix writer
+  }
+  const loop &target = _context.loops[_context.loops.size() - level];
+  jump(next ? target.next : target.stop);
+  start(_context.function->add_block()); // unreachable
+  _final = true;
+}
+
+//---------------------------------------------------------------------------
+
+// a function of its own (nested functions see no locals of the functions around them)
+std::string til::ir_builder::lowerFunction(til::function_node *const node, int lvl) {
+  auto ftype = cdk::functional_type::cast(node->type());
+  std::vector<ir::type> params;
+  for (size_t i = 0; i < node->arguments()->size(); i++) {
+    params.push_back(type(dynamic_cast<cdk::typed_node*>(node->arguments()->node(i))->type()));
+  }
+
+  std::string label = _module.label();
+  _outer.push_back(std::move(_context));
+  _context = context();
+  _context.function = _module.add_function(label, false, params, type(ftype->output(0)));
+  _context.result = ftype->output(0);
+  start(_context.function->add_block());
+
+  // arguments are copied to locals, so that they may be assigned
+  for (size_t i = 0; i < node->arguments()->size(); i++) {
+    auto argument = dynamic_cast<til::declaration_node*>(node->arguments()->node(i));
+    ir::instruction *slot = append(ir::op::SLOT, ir::type::POINTER);
+    slot->i = argument->type()->size();
+    ir::instruction *param = append(ir::op::PARAM, params[i]);
+    param->i = i;
+    append(ir::op::STORE, ir::type::VOID, {slot, param});
+    _context.locals[symbol(argument).get()] = slot;
+  }
+
+  node->block()->accept(this, lvl + 2);
+  if (_context.block->terminator() == nullptr) {
+    append(ir::op::RETURN, ir::type::VOID);
+  }
+  _final = false;
+
+  _context = std::move(_outer.back());
+  _outer.pop_back();
+  return label;
+}
+
+// initial value of a global variable: constants, strings and functions
+til::ir::datum til::ir_builder::datum(std::shared_ptr<cdk::basic_type> type, cdk::expression_node *const node, int lvl) {
+  ir::datum d;
+  auto folded = _annotations.folded(node);
+  if (folded != nullptr && type->name() == cdk::TYPE_DOUBLE) {
+    d.kind = ir::datum::DOUBLE;
+    d.d = std::visit([](auto v) { return static_cast<double>(v); }, *folded);
+  } else if (folded != nullptr && std::holds_alternative<int>(*folded)) {
+    d.kind = ir::datum::INT;
+    d.i = std::get<int>(*folded);
+  } else if (auto literal = dynamic_cast<cdk::integer_node*>(node)) {
+    d.kind = type->name() == cdk::TYPE_DOUBLE ? ir::datum::DOUBLE : ir::datum::INT;
+    d.i = literal->value();
+    d.d = literal->value();
+  } else if (auto literal = dynamic_cast<cdk::double_node*>(node)) {
+    d.kind = ir::datum::DOUBLE;
+    d.d = literal->value();
+  } else if (auto literal = dynamic_cast<cdk::string_node*>(node)) {
+    d.kind = ir::datum::ADDRESS;
+    d.s = _module.add_string(literal->value());
+  } else if (dynamic_cast<til::null_ptr_node*>(node)) {
+    d.kind = ir::datum::INT;
+  } else if (auto function = dynamic_cast<til::function_node*>(node)) {
+    d.kind = ir::datum::ADDRESS;
+    d.s = lowerFunction(function, lvl);
+  } else {
+    throw ir::unsupported{"global initializer"};
+  }
+  return d;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_nil_node(cdk::nil_node * const node, int lvl) {
+  // EMPTY
+}
+void til::ir_builder::do_data_node(cdk::data_node * const node, int lvl) {
+  // EMPTY
+}
+void til::ir_builder::do_not_node(cdk::not_node * const node, int lvl) {
+  ir::instruction *argument = value(node->argument(), lvl);
+  if (argument->type == ir::type::DOUBLE) throw ir::unsupported{"negation of a double"};
+  _value = append(ir::op::CMP, ir::type::INT, {argument, constant(0)});
+  _value->cc = ir::cond::EQ;
+}
+void til::ir_builder::do_and_node(cdk::and_node * const node, int lvl) {
+  logical(node, true, lvl);
+}
+void til::ir_builder::do_or_node(cdk::or_node * const node, int lvl) {
+  logical(node, false, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_sequence_node(cdk::sequence_node * const node, int lvl) {
+  for (size_t i = 0; i < node->size(); i++) {
+    node->node(i)->accept(this, lvl);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_integer_node(cdk::integer_node * const node, int lvl) {
+  _value = constant(node->value());
+}
+
+void til::ir_builder::do_double_node(cdk::double_node * const node, int lvl) {
+  _value = append(ir::op::CONST, ir::type::DOUBLE);
+  _value->d = node->value();
+}
+
+void til::ir_builder::do_string_node(cdk::string_node * const node, int lvl) {
+  _value = append(ir::op::ADDRESS, ir::type::POINTER);
+  _value->s = _module.add_string(node->value());
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_unary_minus_node(cdk::unary_minus_node * const node, int lvl) {
+  ir::instruction *argument = value(node->argument(), lvl);
+  _value = append(ir::op::NEG, type(node->type()), {argument});
+}
+
+void til::ir_builder::do_unary_plus_node(cdk::unary_plus_node * const node, int lvl) {
+  _value = value(node->argument(), lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_add_node(cdk::add_node * const node, int lvl) {
+  _value = arithmetic(node, ir::op::ADD, lvl);
+}
+void til::ir_builder::do_sub_node(cdk::sub_node * const node, int lvl) {
+  _value = arithmetic(node, ir::op::SUB, lvl);
+}
+void til::ir_builder::do_mul_node(cdk::mul_node * const node, int lvl) {
+  _value = arithmetic(node, ir::op::MUL, lvl);
+}
+void til::ir_builder::do_div_node(cdk::div_node * const node, int lvl) {
+  _value = arithmetic(node, ir::op::DIV, lvl);
+}
+void til::ir_builder::do_mod_node(cdk::mod_node * const node, int lvl) {
+  ir::instruction *left = value(node->left(), lvl);
+  ir::instruction *right = value(node->right(), lvl);
+  _value = append(ir::op::MOD, ir::type::INT, {left, right});
+}
+
+void til::ir_builder::do_lt_node(cdk::lt_node * const node, int lvl) {
+  comparison(node, ir::cond::LT, lvl);
+}
+void til::ir_builder::do_le_node(cdk::le_node * const node, int lvl) {
+  comparison(node, ir::cond::LE, lvl);
+}
+void til::ir_builder::do_ge_node(cdk::ge_node * const node, int lvl) {
+  comparison(node, ir::cond::GE, lvl);
+}
+void til::ir_builder::do_gt_node(cdk::gt_node * const node, int lvl) {
+  comparison(node, ir::cond::GT, lvl);
+}
+void til::ir_builder::do_ne_node(cdk::ne_node * const node, int lvl) {
+  comparison(node, ir::cond::NE, lvl);
+}
+void til::ir_builder::do_eq_node(cdk::eq_node * const node, int lvl) {
+  comparison(node, ir::cond::EQ, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_variable_node(cdk::variable_node * const node, int lvl) {
+  auto symbol = this->symbol(node);
+
+  auto local = _context.locals.find(symbol.get());
+  if (local != _context.locals.end()) {
+    _value = local->second;
+    return;
+  }
+  for (auto &outer : _outer) {
+    if (outer.locals.count(symbol.get()) > 0) throw ir::unsupported{"local of an enclosing function"};
+  }
+
+  if (symbol->qualifier() == tEXTERNAL) {
+    _external = &symbol->name();
+    _value = nullptr;
+  } else {
+    _value = append(ir::op::ADDRESS, ir::type::POINTER);
+    _value->s = symbol->name();
+  }
+}
+
+void til::ir_builder::do_rvalue_node(cdk::rvalue_node * const node, int lvl) {
+  ir::instruction *where = address(node->lvalue(), lvl);
+  if (where == nullptr) return; // an external function, to be called
+  _value = append(ir::op::LOAD, type(node->type()), {where});
+}
+
+void til::ir_builder::do_assignment_node(cdk::assignment_node * const node, int lvl) {
+  ir::instruction *v = valueAndCast(node->type(), node->rvalue(), lvl);
+  ir::instruction *where = address(node->lvalue(), lvl);
+  if (where == nullptr) throw ir::unsupported{"assignment to an external function"};
+  append(ir::op::STORE, ir::type::VOID, {where, v});
+  _value = v;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_program_node(til::program_node * const node, int lvl) {
+  // the RTS mandates that the main function be "_main"
+  _context = context();
+  _context.function = _module.add_function("_main", true, {}, ir::type::INT);
+  _context.result = cdk::functional_type::cast(node->type())->output(0);
+  start(_context.function->add_block());
+
+  node->statements()->accept(this, lvl);
+  if (_context.block->terminator() == nullptr) {
+    append(ir::op::RETURN, ir::type::VOID, {constant(0)});
+  }
+  _context = context();
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_evaluation_node(til::evaluation_node * const node, int lvl) {
+  value(node->argument(), lvl);
+}
+
+void til::ir_builder::do_print_node(til::print_node * const node, int lvl) {
+  for (size_t i = 0; i < node->argument()->size(); i++) {
+    auto expr = dynamic_cast<cdk::expression_node*>(node->argument()->node(i));
+    ir::instruction *v = value(expr, lvl);
+
+    const char *print = expr->is_typed(cdk::TYPE_INT) ? "printi" : expr->is_typed(cdk::TYPE_DOUBLE) ? "printd"
+                      : expr->is_typed(cdk::TYPE_STRING) ? "prints" : nullptr;
+    if (print != nullptr) {
+      _module.external(print, true);
+      append(ir::op::CALL, ir::type::VOID, {v})->s = print;
+    }
+  }
+
+  if (node->newline()) {
+    _module.external("println", true);
+    append(ir::op::CALL, ir::type::VOID)->s = "println";
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_read_node(til::read_node * const node, int lvl) {
+  const char *read = node->is_typed(cdk::TYPE_DOUBLE) ? "readd" : "readi";
+  _module.external(read, true);
+  _value = append(ir::op::CALL, node->is_typed(cdk::TYPE_DOUBLE) ? ir::type::DOUBLE : ir::type::INT);
+  _value->s = read;
+}
+
+//---------------------------------------------------------------------------
+
+// rotated loop: a jump to the test at the bottom, which goes back to the body;
+// "next" goes to the test
+void til::ir_builder::do_loop_node(til::loop_node * const node, int lvl) {
+  ir::block *body = _context.function->add_block();
+  ir::block *test = _context.function->add_block();
+  ir::block *end = _context.function->add_block();
+
+  jump(test);
+
+  start(body);
+  _context.loops.push_back({test, end});
+  node->block()->accept(this, lvl + 2);
+  _context.loops.pop_back();
+  jump(test);
+
+  start(test);
+  branch(node->condition(), body, end, lvl);
+  start(end);
+
+  _final = false;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_if_node(til::if_node * const node, int lvl) {
+  ir::block *then = _context.function->add_block();
+  ir::block *end = _context.function->add_block();
+  branch(node->condition(), then, end, lvl);
+  start(then);
+  node->block()->accept(this, lvl + 2);
+  _final = false;
+  jump(end);
+  start(end);
+}
+
+void til::ir_builder::do_if_else_node(til::if_else_node * const node, int lvl) {
+  ir::block *then = _context.function->add_block();
+  ir::block *otherwise = _context.function->add_block();
+  ir::block *end = _context.function->add_block();
+  branch(node->condition(), then, otherwise, lvl);
+  start(then);
+  node->thenblock()->accept(this, lvl + 2);
+  _final = false;
+  jump(end);
+  start(otherwise);
+  node->elseblock()->accept(this, lvl + 2);
+  _final = false;
+  jump(end);
+  start(end);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_declaration_node(til::declaration_node * const node, int lvl) {
+  auto symbol = this->symbol(node);
+
+  if (_context.function != nullptr) {
+    ir::instruction *slot = append(ir::op::SLOT, ir::type::POINTER);
+    slot->i = node->type()->size();
+    _context.locals[symbol.get()] = slot;
+    if (node->initialValue() != nullptr) {
+      ir::instruction *v = valueAndCast(node->type(), node->initialValue(), lvl);
+      append(ir::op::STORE, ir::type::VOID, {slot, v});
+    }
+    return;
+  }
+
+  if (symbol->qualifier() == tFORWARD || symbol->qualifier() == tEXTERNAL) {
+    _module.external(symbol->name(), true);
+    return;
+  }
+  _module.external(symbol->name(), false);
+
+  ir::global g;
+  g.name = symbol->name();
+  g.exported = symbol->qualifier() == tPUBLIC;
+  g.size = node->type()->size();
+  if (node->initialValue() != nullptr) {
+    g.data.push_back(datum(node->type(), node->initialValue(), lvl));
+  }
+  _module.add_global(std::move(g));
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_function_call_node(til::function_call_node * const node, int lvl) {
+  std::shared_ptr<cdk::functional_type> func_type = (node->identifier() == nullptr)
+      ? cdk::functional_type::cast(symbol(node)->type())
+      : cdk::functional_type::cast(node->identifier()->type());
+
+  // arguments are evaluated right-to-left, then the function
+  std::vector<ir::instruction*> arguments(node->arguments()->size());
+  for (size_t i = arguments.size(); i > 0; i--) {
+    auto arg = dynamic_cast<cdk::expression_node*>(node->arguments()->node(i - 1));
+    arguments[i - 1] = valueAndCast(func_type->input(i - 1), arg, lvl + 2);
+  }
+
+  std::string callee;
+  if (node->identifier() == nullptr) {
+    callee = _context.function->name(); // "@"
+  } else {
+    _value = nullptr;
+    _external = nullptr;
+    node->identifier()->accept(this, lvl);
+    if (_external != nullptr) {
+      callee = *_external;
+    } else if (_value != nullptr) {
+      arguments.insert(arguments.begin(), _value);
+    } else {
+      throw ir::unsupported{"call of a function without an address"};
+    }
+  }
+
+  _value = append(ir::op::CALL, type(node->type()), arguments);
+  _value->s = callee;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_function_node(til::function_node * const node, int lvl) {
+  if (_context.function == nullptr) throw ir::unsupported{"function outside declarations"};
+  std::string label = lowerFunction(node, lvl);
+  _value = append(ir::op::ADDRESS, ir::type::FUNCTION);
+  _value->s = label;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_return_node(til::return_node * const node, int lvl) {
+  std::shared_ptr<cdk::basic_type> return_type = cdk::functional_type::cast(symbol(node)->type())->output(0);
+
+  if (return_type->name() != cdk::TYPE_VOID) {
+    ir::instruction *v = valueAndCast(return_type, node->value(), lvl + 2);
+    append(ir::op::RETURN, ir::type::VOID, {v});
+  } else {
+    append(ir::op::RETURN, ir::type::VOID);
+  }
+
+  start(_context.function->add_block()); // unreachable
+  _final = true;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_next_node(til::next_node * const node, int lvl) {
+  loopControl(node->level(), true);
+}
+
+void til::ir_builder::do_stop_node(til::stop_node * const node, int lvl) {
+  loopControl(node->level(), false);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_block_node(til::block_node * const node, int lvl) {
+  node->declarations()->accept(this, lvl + 2);
+
+  _final = false;
+  for (size_t i = 0; i < node->instructions()->size(); i++) {
+    if (_final) throw ir::unsupported{"instructions after a final instruction"}; // reported by the postfix writer
+    node->instructions()->node(i)->accept(this, lvl + 2);
+  }
+  _final = false;
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_sizeof_node(til::sizeof_node * const node, int lvl) {
+  _value = constant(node->expression()->type()->size());
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_objects_node(til::objects_node * const node, int lvl) {
+  auto referenced = cdk::reference_type::cast(node->type())->referenced();
+  ir::instruction *bytes = scaled(node->argument(), referenced->size(), lvl);
+  _value = append(ir::op::ALLOC, ir::type::POINTER, {bytes});
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_null_ptr_node(til::null_ptr_node * const node, int lvl) {
+  _value = append(ir::op::CONST, ir::type::POINTER);
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_ptr_index_node(til::ptr_index_node * const node, int lvl) {
+  ir::instruction *base = value(node->base(), lvl + 2);
+  ir::instruction *offset = scaled(node->index(), node->type()->size(), lvl + 2);
+  _value = append(ir::op::ADD, ir::type::POINTER, {base, offset});
+}
+
+//---------------------------------------------------------------------------
+
+void til::ir_builder::do_address_of_node(til::address_of_node * const node, int lvl) {
+  _value = address(node->lvalue(), lvl + 2);
+}
@@ -0,0 +1,89 @@
+#ifndef __TIL_TARGETS_IR_BUILDER_H__
+#define __TIL_TARGETS_IR_BUILDER_H__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cdk/ast/lvalue_node.h>
+#include "targets/basic_ast_visitor.h"
+#include "targets/annotations.h"
+#include "ir/ir.h"
+
+namespace til {
+
+  /**
+   * Lowering of one typed top-level node (a declaration or the program) to
+   * the IR: each function (nested ones included) becomes an ir::function,
+   * global variables and string literals go to the module. The code means
+   * what the postfix writer would write: same evaluation order (arguments
+   * right to left), same promotions, rotated loops, conditions as jumps.
+   * Constructs it does not handle (function values that need conversions,
+   * synthesized nodes) throw ir::unsupported.
+   */
+  class ir_builder: public basic_ast_visitor {
+    struct loop {
+      ir::block *next;  // the bottom test
+      ir::block *stop;  // after the loop
+    };
+
+    // what is being built, saved while a nested function is lowered
+    struct context {
+      ir::function *function = nullptr;
+      ir::block *block = nullptr;
+      std::shared_ptr<cdk::basic_type> result;
+      std::unordered_map<const til::symbol*, ir::instruction*> locals; // addresses (SLOT)
+      std::vector<loop> loops;
+    };
+
+    const til::annotations &_annotations;
+    ir::module &_module;
+    context _context;
+    std::vector<context> _outer;        // of the functions around the current one
+    ir::instruction *_value = nullptr;  // of the last expression visited
+    const std::string *_external = nullptr; // external function named by the last variable visited
+    bool _final = false;                // the last instruction was return, stop or next
+
+  public:
+    ir_builder(std::shared_ptr<cdk::compiler> compiler, const til::annotations &annotations, ir::module &module) :
+        basic_ast_visitor(compiler), _annotations(annotations), _module(module) {
+    }
+
+  public:
+    ~ir_builder() {
+      // EMPTY
+    }
+
+  protected:
+    static ir::type type(std::shared_ptr<cdk::basic_type> t);
+    std::shared_ptr<til::symbol> symbol(cdk::basic_node *const node) const;
+
+    ir::instruction *append(ir::op code, ir::type t, const std::vector<ir::instruction*> &operands = {});
+    ir::instruction *constant(int i);
+    ir::block *start(ir::block *b);
+    void jump(ir::block *to);
+
+    ir::instruction *value(cdk::expression_node *const node, int lvl);
+    ir::instruction *address(cdk::lvalue_node *const node, int lvl);
+    ir::instruction *valueAndCast(std::shared_ptr<cdk::basic_type> const type, cdk::expression_node *const node, int lvl);
+    ir::instruction *scaled(cdk::expression_node *const offset, size_t size, int lvl);
+    ir::instruction *arithmetic(cdk::binary_operation_node *const node, ir::op code, int lvl);
+    void comparison(cdk::binary_operation_node *const node, ir::cond cc, int lvl);
+    void logical(cdk::binary_operation_node *const node, bool conjunction, int lvl);
+    void branch(cdk::expression_node *const condition, ir::block *yes, ir::block *no, int lvl);
+    bool boolean(cdk::expression_node *const node) const;
+    void loopControl(int level, bool next);
+    std::string lowerFunction(til::function_node *const node, int lvl);
+    ir::datum datum(std::shared_ptr<cdk::basic_type> type, cdk::expression_node *const node, int lvl);
+
+  public:
+    // do not edit these lines
+#define __IN_VISITOR_HEADER__
+#include ".auto/visitor_decls.h"       // automatically generated
+#undef __IN_VISITOR_HEADER__
+    // do not edit these lines: end
+
+  };
+
+} // til
+
+#endif
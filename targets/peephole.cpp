@@ -0,0 +1,129 @@
+#include "targets/peephole.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using instruction = til::peephole::instruction;
+  using opcode = til::peephole::opcode;
+  using rule = til::peephole::rule;
+  using labels = til::peephole::labels;
+
+  // DUP; <variable>; ST; TRASH: the value of an assignment is discarded (evaluation instruction)
+  rule discarded(const char *name, opcode dup, opcode address, opcode store, int bytes) {
+    return {name, {dup, address, store, opcode::TRASH},
+            [bytes](const instruction *w, const labels &used) { return w[3].i == bytes; },
+            [](const instruction *w) { return std::vector<instruction>{w[1], w[2]}; }};
+  }
+
+  // <variable>; ST; <variable>; LD: the value just stored is still on the stack before the store
+  rule reloaded(const char *name, opcode address, opcode store, opcode load, opcode dup) {
+    return {name, {address, store, address, load},
+            [](const instruction *w, const labels &used) { return w[0].i == w[2].i && w[0].s == w[2].s; },
+            [dup](const instruction *w) { return std::vector<instruction>{{dup, 0, 0, {}}, w[0], w[1]}; }};
+  }
+
+} // namespace
+
+const std::vector<rule> &til::peephole::rules() {
+  static const std::vector<rule> table = {
+    // x; INT 0; EQ; JZ l  =>  x; JNZ l  (and the converse)
+    {"not-jz", {opcode::INT, opcode::EQ, opcode::JZ},
+     [](const instruction *w, const labels &used) { return w[0].i == 0; },
+     [](const instruction *w) { return std::vector<instruction>{{opcode::JNZ, 0, 0, w[2].s}}; }},
+    {"not-jnz", {opcode::INT, opcode::EQ, opcode::JNZ},
+     [](const instruction *w, const labels &used) { return w[0].i == 0; },
+     [](const instruction *w) { return std::vector<instruction>{{opcode::JZ, 0, 0, w[2].s}}; }},
+
+    discarded("discard-local", opcode::DUP32, opcode::LOCAL, opcode::STINT, 4),
+    discarded("discard-global", opcode::DUP32, opcode::ADDR, opcode::STINT, 4),
+    discarded("discard-local-double", opcode::DUP64, opcode::LOCAL, opcode::STDOUBLE, 8),
+    discarded("discard-global-double", opcode::DUP64, opcode::ADDR, opcode::STDOUBLE, 8),
+
+    reloaded("reload-local", opcode::LOCAL, opcode::STINT, opcode::LDINT, opcode::DUP32),
+    reloaded("reload-global", opcode::ADDR, opcode::STINT, opcode::LDINT, opcode::DUP32),
+    reloaded("reload-local-double", opcode::LOCAL, opcode::STDOUBLE, opcode::LDDOUBLE, opcode::DUP64),
+    reloaded("reload-global-double", opcode::ADDR, opcode::STDOUBLE, opcode::LDDOUBLE, opcode::DUP64),
+
+    // ALIGN; LABEL l  =>  LABEL l, when l is only the target of jumps
+    {"align-label", {opcode::ALIGN, opcode::LABEL},
+     [](const instruction *w, const labels &used) { return used.jumpOnly(w[1].s); },
+     [](const instruction *w) { return std::vector<instruction>{w[1]}; }},
+
+    // JMP l; LABEL l  =>  LABEL l
+    {"jmp-next", {opcode::JMP, opcode::LABEL},
+     [](const instruction *w, const labels &used) { return w[0].s == w[1].s; },
+     [](const instruction *w) { return std::vector<instruction>{w[1]}; }},
+  };
+  return table;
+}
+
+//---------------------------------------------------------------------------
+
+void til::peephole::run(postfix_buffer &code) {
+  labels used;
+  for (const instruction &ins : code.code()) {
+    switch (ins.op) {
+      case opcode::JMP: case opcode::JZ: case opcode::JNZ: case opcode::JEQ: case opcode::JNE:
+      case opcode::JLT: case opcode::JLE: case opcode::JGT: case opcode::JGE:
+        used.jumped.insert(ins.s);
+        break;
+      case opcode::ADDR: case opcode::SADDR: case opcode::CALL: case opcode::GLOBAL: case opcode::TEXT:
+        used.referenced.insert(ins.s);
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::vector<instruction> out;
+  out.reserve(code.size());
+  for (instruction &ins : code.code()) {
+    out.push_back(std::move(ins));
+    reduce(out, used);
+  }
+  code.code() = std::move(out);
+}
+
+// replace the end of the code while some rule matches it
+void til::peephole::reduce(std::vector<instruction> &out, const labels &used) {
+  const std::vector<rule> &table = rules();
+  for (size_t r = 0; r < table.size(); ) {
+    const rule &rule = table[r];
+    size_t n = rule.pattern.size();
+    bool match = out.size() >= n;
+    for (size_t k = 1; match && k <= n; k++) { // last opcode first: it rarely matches
+      match = out[out.size() - k].op == rule.pattern[n - k];
+    }
+    if (!match || !rule.applies(out.data() + out.size() - n, used)) {
+      r++;
+      continue;
+    }
+
+    std::vector<instruction> replacement = rule.rewrite(out.data() + out.size() - n);
+    out.resize(out.size() - n);
+    for (instruction &ins : replacement) {
+      out.push_back(std::move(ins));
+    }
+    _removed += n - replacement.size();
+    _fired[r]++;
+    r = 0; // the new end may match again
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::peephole::merge(const peephole &other) {
+  for (size_t r = 0; r < _fired.size(); r++) {
+    _fired[r] += other._fired[r];
+  }
+  _removed += other._removed;
+}
+
+void til::peephole::report(std::ostream &os) const {
+  os << "peephole: " << _removed << " instructions removed";
+  for (size_t r = 0; r < _fired.size(); r++) {
+    os << (r == 0 ? " (" : ", ") << rules()[r].name << ' ' << _fired[r];
+  }
+  os << ')' << std::endl;
+}
@@ -0,0 +1,73 @@
+#ifndef __TIL_TARGETS_PEEPHOLE_H__
+#define __TIL_TARGETS_PEEPHOLE_H__
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "targets/postfix_buffer.h"
+
+namespace til {
+
+  /**
+   * Peephole optimizer for the code of one unit (its labels are not used
+   * elsewhere). Instructions are moved, one at a time, to the end of the
+   * optimized code; whenever the last instructions match one of the rules,
+   * they are replaced (and the new end is matched again).
+   */
+  class peephole {
+  public:
+    using instruction = postfix_buffer::instruction;
+    using opcode = postfix_buffer::opcode;
+
+    /** Labels of the unit, by the way they are used. */
+    struct labels {
+      std::unordered_set<std::string> jumped;     // targets of jumps
+      std::unordered_set<std::string> referenced; // any other use (addresses, calls, ...)
+
+      /** ALIGN only matters to labels whose address is taken */
+      bool jumpOnly(const std::string &label) const {
+        return label.compare(0, 2, "_L") == 0 && referenced.count(label) == 0;
+      }
+    };
+
+    /**
+     * Rewrite rule: when the opcodes of the last instructions are `pattern'
+     * and `applies' holds for them, they are replaced by `rewrite'.
+     */
+    struct rule {
+      const char *name;
+      std::vector<opcode> pattern;
+      std::function<bool(const instruction *window, const labels &used)> applies;
+      std::function<std::vector<instruction>(const instruction *window)> rewrite;
+    };
+
+    /** The rules, in the order they are tried. */
+    static const std::vector<rule> &rules();
+
+  private:
+    std::vector<size_t> _fired;
+    size_t _removed = 0;
+
+  public:
+    peephole() : _fired(rules().size(), 0) {
+    }
+
+  public:
+    /** Optimize the code in place. */
+    void run(postfix_buffer &code);
+
+    /** Add the counts of another optimizer to these. */
+    void merge(const peephole &other);
+
+    /** Times each rule fired, and instructions saved. */
+    void report(std::ostream &os) const;
+
+  private:
+    void reduce(std::vector<instruction> &out, const labels &used);
+  };
+
+} // til
+
+#endif
@@ -0,0 +1,142 @@
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include "targets/postfix_buffer.h"
+
+//---------------------------------------------------------------------------
+
+void til::postfix_buffer::append(postfix_buffer &&other) {
+  if (_code.empty()) {
+    _code = std::move(other._code);
+  } else {
+    _code.insert(_code.end(), std::make_move_iterator(other._code.begin()),
+                 std::make_move_iterator(other._code.end()));
+  }
+  other._code.clear();
+}
+
+//---------------------------------------------------------------------------
+
+void til::postfix_buffer::replay(cdk::basic_postfix_emitter &pf) const {
+  for (const instruction &ins : _code) {
+    replay(ins, pf);
+  }
+}
+
+void til::postfix_buffer::replay(const instruction &ins, cdk::basic_postfix_emitter &pf) {
+  switch (ins.op) {
+    case opcode::RODATA: pf.RODATA(); break;
+    case opcode::DATA: pf.DATA(); break;
+    case opcode::BSS: pf.BSS(); break;
+    case opcode::ALIGN: pf.ALIGN(); break;
+    case opcode::SP: pf.SP(); break;
+    case opcode::ALLOC: pf.ALLOC(); break;
+    case opcode::LDINT: pf.LDINT(); break;
+    case opcode::LDDOUBLE: pf.LDDOUBLE(); break;
+    case opcode::STINT: pf.STINT(); break;
+    case opcode::STDOUBLE: pf.STDOUBLE(); break;
+    case opcode::DUP32: pf.DUP32(); break;
+    case opcode::DUP64: pf.DUP64(); break;
+    case opcode::ADD: pf.ADD(); break;
+    case opcode::SUB: pf.SUB(); break;
+    case opcode::MUL: pf.MUL(); break;
+    case opcode::DIV: pf.DIV(); break;
+    case opcode::MOD: pf.MOD(); break;
+    case opcode::NEG: pf.NEG(); break;
+    case opcode::DADD: pf.DADD(); break;
+    case opcode::DSUB: pf.DSUB(); break;
+    case opcode::DMUL: pf.DMUL(); break;
+    case opcode::DDIV: pf.DDIV(); break;
+    case opcode::DNEG: pf.DNEG(); break;
+    case opcode::I2D: pf.I2D(); break;
+    case opcode::AND: pf.AND(); break;
+    case opcode::OR: pf.OR(); break;
+    case opcode::EQ: pf.EQ(); break;
+    case opcode::NE: pf.NE(); break;
+    case opcode::LT: pf.LT(); break;
+    case opcode::LE: pf.LE(); break;
+    case opcode::GT: pf.GT(); break;
+    case opcode::GE: pf.GE(); break;
+    case opcode::DCMP: pf.DCMP(); break;
+    case opcode::BRANCH: pf.BRANCH(); break;
+    case opcode::LEAVE: pf.LEAVE(); break;
+    case opcode::RET: pf.RET(); break;
+    case opcode::STFVAL32: pf.STFVAL32(); break;
+    case opcode::STFVAL64: pf.STFVAL64(); break;
+    case opcode::LDFVAL32: pf.LDFVAL32(); break;
+    case opcode::LDFVAL64: pf.LDFVAL64(); break;
+    case opcode::SINT: pf.SINT(ins.i); break;
+    case opcode::SALLOC: pf.SALLOC(ins.i); break;
+    case opcode::INT: pf.INT(ins.i); break;
+    case opcode::LOCAL: pf.LOCAL(ins.i); break;
+    case opcode::TRASH: pf.TRASH(ins.i); break;
+    case opcode::ENTER: pf.ENTER(ins.i); break;
+    case opcode::SDOUBLE: pf.SDOUBLE(ins.d); break;
+    case opcode::DOUBLE: pf.DOUBLE(ins.d); break;
+    case opcode::TEXT: pf.TEXT(ins.s); break;
+    case opcode::LABEL: pf.LABEL(ins.s); break;
+    case opcode::EXTERN: pf.EXTERN(ins.s); break;
+    case opcode::SSTRING: pf.SSTRING(ins.s); break;
+    case opcode::SADDR: pf.SADDR(ins.s); break;
+    case opcode::ADDR: pf.ADDR(ins.s); break;
+    case opcode::JMP: pf.JMP(ins.s); break;
+    case opcode::JZ: pf.JZ(ins.s); break;
+    case opcode::JNZ: pf.JNZ(ins.s); break;
+    case opcode::JEQ: pf.JEQ(ins.s); break;
+    case opcode::JNE: pf.JNE(ins.s); break;
+    case opcode::JLT: pf.JLT(ins.s); break;
+    case opcode::JLE: pf.JLE(ins.s); break;
+    case opcode::JGT: pf.JGT(ins.s); break;
+    case opcode::JGE: pf.JGE(ins.s); break;
+    case opcode::CALL: pf.CALL(ins.s); break;
+    case opcode::GLOBAL: pf.GLOBAL(ins.s, ins.i == KIND_FUNC ? pf.FUNC() : pf.OBJ()); break;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// one instruction per line: opcode, integer operand, bits of the double
+// operand and the string operand, preceded by its length
+void til::postfix_buffer::write(std::ostream &os) const {
+  for (const instruction &ins : _code) {
+    uint64_t bits;
+    std::memcpy(&bits, &ins.d, sizeof(bits));
+    os << static_cast<int>(ins.op) << ' ' << ins.i << ' ' << bits << ' ' << ins.s.size() << ' ';
+    os.write(ins.s.data(), ins.s.size());
+    os << '\n';
+  }
+}
+
+bool til::postfix_buffer::read(std::istream &is) {
+  int op;
+  while (is >> op) {
+    instruction ins{static_cast<opcode>(op), 0, 0, {}};
+    uint64_t bits;
+    size_t length;
+    if (op < 0 || op > static_cast<int>(opcode::LDFVAL64)) return false;
+    if (!(is >> ins.i >> bits >> length) || is.get() != ' ') return false;
+    std::memcpy(&ins.d, &bits, sizeof(bits));
+    ins.s.resize(length);
+    if (!is.read(ins.s.data(), length) || is.get() != '\n') return false;
+    _code.push_back(std::move(ins));
+  }
+  return is.eof();
+}
+
+//---------------------------------------------------------------------------
+
+void til::postfix_buffer::relabel(int from, int to) {
+  if (from == to) return;
+
+  // identifiers cannot contain '_', so "_L<n>_" only occurs in generated names
+  const std::string old_prefix = "_L" + std::to_string(from) + "_";
+  const std::string new_prefix = "_L" + std::to_string(to) + "_";
+  for (instruction &ins : _code) {
+    if (ins.op == opcode::SSTRING) continue; // string contents are not names
+    for (size_t pos = ins.s.find(old_prefix); pos != std::string::npos;
+         pos = ins.s.find(old_prefix, pos + new_prefix.size())) {
+      ins.s.replace(pos, old_prefix.size(), new_prefix);
+    }
+  }
+}
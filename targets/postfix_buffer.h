@@ -0,0 +1,168 @@
+#ifndef __TIL_TARGETS_POSTFIX_BUFFER_H__
+#define __TIL_TARGETS_POSTFIX_BUFFER_H__
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cdk/emitters/basic_postfix_emitter.h>
+
+namespace til {
+
+  /**
+   * In-memory postfix code. It offers the subset of the postfix emitter
+   * interface used by the postfix writer, records each instruction, and
+   * forwards the whole sequence to a real emitter with replay().
+   */
+  class postfix_buffer {
+  public:
+    enum class opcode {
+      // sections, labels and data
+      TEXT, RODATA, DATA, BSS, ALIGN, LABEL, GLOBAL, EXTERN,
+      SINT, SDOUBLE, SSTRING, SADDR, SALLOC,
+      // literals and addresses
+      INT, DOUBLE, ADDR, LOCAL, SP, ALLOC,
+      // memory
+      LDINT, LDDOUBLE, STINT, STDOUBLE, DUP32, DUP64, TRASH,
+      // arithmetic and logic
+      ADD, SUB, MUL, DIV, MOD, NEG, DADD, DSUB, DMUL, DDIV, DNEG, I2D,
+      AND, OR, EQ, NE, LT, LE, GT, GE, DCMP,
+      // control flow and functions
+      JMP, JZ, JNZ, JEQ, JNE, JLT, JLE, JGT, JGE, CALL, BRANCH, ENTER, LEAVE, RET,
+      STFVAL32, STFVAL64, LDFVAL32, LDFVAL64,
+    };
+
+    /** GLOBAL symbol kinds (see FUNC() and OBJ()). */
+    enum { KIND_OBJ = 0, KIND_FUNC = 1 };
+
+    struct instruction {
+      opcode op;
+      int i = 0;          // integer operand (INT, LOCAL, TRASH, GLOBAL kind, ...)
+      double d = 0;       // DOUBLE/SDOUBLE operand
+      std::string s;      // label, symbol or string operand
+    };
+
+  private:
+    std::vector<instruction> _code;
+
+    void emit(opcode op) {
+      _code.push_back({op, 0, 0, {}});
+    }
+    void emit(opcode op, int i) {
+      _code.push_back({op, i, 0, {}});
+    }
+    void emit(opcode op, const std::string &s, int i = 0) {
+      _code.push_back({op, i, 0, s});
+    }
+
+  public:
+    const std::vector<instruction> &code() const {
+      return _code;
+    }
+    std::vector<instruction> &code() {
+      return _code;
+    }
+    size_t size() const {
+      return _code.size();
+    }
+
+    /** Move the instructions of another buffer to the end of this one. */
+    void append(postfix_buffer &&other);
+
+    /** Send every recorded instruction, in order, to the emitter. */
+    void replay(cdk::basic_postfix_emitter &pf) const;
+
+    /** Send one instruction to the emitter. */
+    static void replay(const instruction &ins, cdk::basic_postfix_emitter &pf);
+
+    /** Save the instructions in a form read() accepts. */
+    void write(std::ostream &os) const;
+
+    /** Append the instructions saved by write(); false if the input is damaged. */
+    bool read(std::istream &is);
+
+    /** Rename the labels of namespace `from' (_L<from>_<n>) to namespace `to'. */
+    void relabel(int from, int to);
+
+  public:
+    int FUNC() { return KIND_FUNC; }
+    int OBJ() { return KIND_OBJ; }
+
+    void TEXT(const std::string &label) { emit(opcode::TEXT, label); }
+    void RODATA() { emit(opcode::RODATA); }
+    void DATA() { emit(opcode::DATA); }
+    void BSS() { emit(opcode::BSS); }
+    void ALIGN() { emit(opcode::ALIGN); }
+    void LABEL(const std::string &label) { emit(opcode::LABEL, label); }
+    void GLOBAL(const std::string &name, int kind) { emit(opcode::GLOBAL, name, kind); }
+    void EXTERN(const std::string &name) { emit(opcode::EXTERN, name); }
+
+    void SINT(int value) { emit(opcode::SINT, value); }
+    void SDOUBLE(double value) { _code.push_back({opcode::SDOUBLE, 0, value, {}}); }
+    void SSTRING(const std::string &value) { emit(opcode::SSTRING, value); }
+    void SADDR(const std::string &label) { emit(opcode::SADDR, label); }
+    void SALLOC(int bytes) { emit(opcode::SALLOC, bytes); }
+
+    void INT(int value) { emit(opcode::INT, value); }
+    void DOUBLE(double value) { _code.push_back({opcode::DOUBLE, 0, value, {}}); }
+    void ADDR(const std::string &label) { emit(opcode::ADDR, label); }
+    void LOCAL(int offset) { emit(opcode::LOCAL, offset); }
+    void SP() { emit(opcode::SP); }
+    void ALLOC() { emit(opcode::ALLOC); }
+
+    void LDINT() { emit(opcode::LDINT); }
+    void LDDOUBLE() { emit(opcode::LDDOUBLE); }
+    void STINT() { emit(opcode::STINT); }
+    void STDOUBLE() { emit(opcode::STDOUBLE); }
+    void DUP32() { emit(opcode::DUP32); }
+    void DUP64() { emit(opcode::DUP64); }
+    void TRASH(int bytes) { emit(opcode::TRASH, bytes); }
+
+    void ADD() { emit(opcode::ADD); }
+    void SUB() { emit(opcode::SUB); }
+    void MUL() { emit(opcode::MUL); }
+    void DIV() { emit(opcode::DIV); }
+    void MOD() { emit(opcode::MOD); }
+    void NEG() { emit(opcode::NEG); }
+    void DADD() { emit(opcode::DADD); }
+    void DSUB() { emit(opcode::DSUB); }
+    void DMUL() { emit(opcode::DMUL); }
+    void DDIV() { emit(opcode::DDIV); }
+    void DNEG() { emit(opcode::DNEG); }
+    void I2D() { emit(opcode::I2D); }
+    void AND() { emit(opcode::AND); }
+    void OR() { emit(opcode::OR); }
+    void EQ() { emit(opcode::EQ); }
+    void NE() { emit(opcode::NE); }
+    void LT() { emit(opcode::LT); }
+    void LE() { emit(opcode::LE); }
+    void GT() { emit(opcode::GT); }
+    void GE() { emit(opcode::GE); }
+    void DCMP() { emit(opcode::DCMP); }
+
+    void JMP(const std::string &label) { emit(opcode::JMP, label); }
+    void JZ(const std::string &label) { emit(opcode::JZ, label); }
+    void JNZ(const std::string &label) { emit(opcode::JNZ, label); }
+    /** Compare the two values on the stack (second < top, ...) and jump. */
+    void JEQ(const std::string &label) { emit(opcode::JEQ, label); }
+    void JNE(const std::string &label) { emit(opcode::JNE, label); }
+    void JLT(const std::string &label) { emit(opcode::JLT, label); }
+    void JLE(const std::string &label) { emit(opcode::JLE, label); }
+    void JGT(const std::string &label) { emit(opcode::JGT, label); }
+    void JGE(const std::string &label) { emit(opcode::JGE, label); }
+    void CALL(const std::string &name) { emit(opcode::CALL, name); }
+    void BRANCH() { emit(opcode::BRANCH); }
+    void ENTER(size_t bytes) { emit(opcode::ENTER, static_cast<int>(bytes)); }
+    /** ENTER whose frame size is set later: @return its position, for ENTER(position, bytes) */
+    size_t ENTER() { emit(opcode::ENTER, 0); return _code.size() - 1; }
+    void ENTER(size_t position, size_t bytes) { _code[position].i = static_cast<int>(bytes); }
+    void LEAVE() { emit(opcode::LEAVE); }
+    void RET() { emit(opcode::RET); }
+    void STFVAL32() { emit(opcode::STFVAL32); }
+    void STFVAL64() { emit(opcode::STFVAL64); }
+    void LDFVAL32() { emit(opcode::LDFVAL32); }
+    void LDFVAL64() { emit(opcode::LDFVAL64); }
+  };
+
+} // til
+
+#endif
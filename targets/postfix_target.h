@@ -3,7 +3,14 @@
 
 #include <cdk/targets/basic_target.h>
 #include <cdk/ast/basic_node.h>
-#include "targets/postfix_writer.h"
+#include "arena.h"
+#include "interner.h"
+#include "options.h"
+#include "timings.h"
+#include "targets/chunked_output.h"
+#include "targets/code_generator.h"
+#include "targets/declaration_stream.h"
+#include "targets/sse2_lowering.h"
 
 #include <cdk/emitters/postfix_ix86_emitter.h>
 
@@ -19,16 +26,54 @@ namespace til {
 
   public:
     bool evaluate(std::shared_ptr<cdk::compiler> compiler) {
-      // this symbol table will be used to check identifiers
-      // during code generation
-      cdk::symbol_table<til::symbol> symtab;
+      til::timings::instance().parsed();
 
-      // this is the backend postfix machine
-      cdk::postfix_ix86_emitter pf(compiler);
+      // type every node once, before any code is generated; then generate code
+      // for each top-level declaration, possibly in parallel (in streaming mode,
+      // only the program is left: the declarations were compiled while parsing)
+      til::declaration_stream &stream = til::declaration_stream::instance();
+      code_generator &generator = stream.generator(compiler);
+      if (!stream.ok() || !generator.annotate(compiler->ast())) return false;
 
-      // generate assembly code from the syntax tree
-      postfix_writer writer(compiler, symtab, pf);
-      compiler->ast()->accept(&writer, 0);
+      postfix_buffer &code = stream.code();
+      generator.generate(code);
+      if (compiler->debug()) {
+        generator.report(std::cerr);
+      }
+      stream.finish();
+
+      // collect the emitted text in large chunks before it reaches the output file
+      std::ostream &os = *compiler->ostream();
+      chunked_output buffer(os.rdbuf());
+      os.rdbuf(&buffer);
+      {
+        // this is the backend postfix machine (with SSE2 for doubles, unless turned off)
+        til::timings::probe probe(til::timings::EMIT);
+        cdk::postfix_ix86_emitter pf(compiler);
+        if (til::options::instance().sse2()) {
+          sse2_lowering sse2(pf, os);
+          sse2.replay(code);
+          if (compiler->debug()) {
+            sse2.report(std::cerr);
+          }
+        } else {
+          code.replay(pf);
+        }
+      }
+      {
+        til::timings::probe probe(til::timings::FLUSH);
+        buffer.drain();
+      }
+      os.rdbuf(buffer.target());
+
+      stream.cache().report(std::cerr); // only when the cache is in use
+      if (compiler->debug()) {
+        til::arena::instance().report(std::cerr);
+        til::interner::instance().report(std::cerr);
+        std::cerr << "output: " << buffer.bytes() << " bytes in " << buffer.writes() << " writes" << std::endl;
+      }
+
+      til::timings::instance().save();
 
       return true;
     }
@@ -1,12 +1,171 @@
+#include <cstdint>
 #include <string>
 #include <sstream>
 #include "targets/type_checker.h"
 #include "targets/postfix_writer.h"
-#include "targets/frame_size_calculator.h"
 #include ".auto/all_nodes.h"  // all_nodes.h is automatically generated
 
 #include "til_parser.tab.h"
 
+// nodes seen by the typing pass are trusted; synthesized ones are still checked
+#define ASSERT_CHECKED { if (!_annotations.checked(node)) ASSERT_SAFE_EXPRESSIONS; }
+#define ASSERT_DECLARED { if (_annotations.checked(node)) declare(node); else ASSERT_SAFE_EXPRESSIONS; }
+// expressions computed by the folding pass are written as their value (or simpler equivalent)
+#define FOLDED { if (writeFolded(node, lvl)) return; }
+
+//---------------------------------------------------------------------------
+
+void til::postfix_writer::declare(cdk::basic_node *const node) {
+  auto symbol = _annotations.symbol(node);
+  if (!_symtab.insert(symbol->name(), symbol)) {
+    _symtab.replace(symbol->name(), symbol);
+  }
+  set_new_symbol(symbol);
+}
+
+// set the size of the frame whose ENTER is at the given position
+void til::postfix_writer::closeFrame(size_t enter) {
+  size_t bytes = -_frameLow;
+  _pf.ENTER(enter, bytes);
+  _frameUsage.frames++;
+  _frameUsage.bytes += bytes;
+  _frameUsage.unshared += _frameUnshared;
+}
+
+std::shared_ptr<til::symbol> til::postfix_writer::resolve(cdk::basic_node *const node, const std::string &name, size_t from) {
+  auto symbol = _annotations.symbol(node);
+  return symbol != nullptr ? symbol : _symtab.find(name, from);
+}
+
+// push the value found by the folding pass, or write the simpler equivalent it found
+bool til::postfix_writer::writeFolded(cdk::expression_node *const node, int lvl) {
+  if (auto value = _annotations.folded(node)) {
+    if (std::holds_alternative<double>(*value)) {
+      if (inFunction()) _pf.DOUBLE(std::get<double>(*value));
+      else _pf.SDOUBLE(std::get<double>(*value));
+    } else {
+      if (inFunction()) _pf.INT(std::get<int>(*value));
+      else _pf.SINT(std::get<int>(*value));
+    }
+    return true;
+  }
+  if (auto equivalent = _annotations.simplified(node)) {
+    equivalent->accept(this, lvl);
+    return true;
+  }
+  return false;
+}
+
+// push offset*size (a pointer displacement): constant offsets are scaled here
+void til::postfix_writer::writeScaled(cdk::expression_node *const offset, size_t size, int lvl) {
+  auto value = _annotations.folded(offset);
+  if (value != nullptr && std::holds_alternative<int>(*value)) {
+    _pf.INT(static_cast<int>(static_cast<uint32_t>(std::get<int>(*value)) * static_cast<uint32_t>(size)));
+    return;
+  }
+  offset->accept(this, lvl);
+  _pf.INT(size);
+  _pf.MUL();
+}
+
+// whether the value is always 0 or 1 (&& and || combine their operands bitwise)
+bool til::postfix_writer::boolean(cdk::expression_node *const node) const {
+  if (auto value = _annotations.folded(node)) {
+    return std::holds_alternative<int>(*value) && (std::get<int>(*value) == 0 || std::get<int>(*value) == 1);
+  }
+  if (auto equivalent = _annotations.simplified(node)) {
+    return boolean(equivalent);
+  }
+  if (auto logical = dynamic_cast<cdk::and_node*>(node)) {
+    return boolean(logical->left()) && boolean(logical->right());
+  }
+  if (auto logical = dynamic_cast<cdk::or_node*>(node)) {
+    return boolean(logical->left()) && boolean(logical->right());
+  }
+  return dynamic_cast<cdk::not_node*>(node) || dynamic_cast<cdk::lt_node*>(node) || dynamic_cast<cdk::le_node*>(node)
+      || dynamic_cast<cdk::gt_node*>(node) || dynamic_cast<cdk::ge_node*>(node) || dynamic_cast<cdk::eq_node*>(node)
+      || dynamic_cast<cdk::ne_node*>(node);
+}
+
+// jump to the label when the condition is `when' (true: nonzero), without computing its value
+void til::postfix_writer::writeJump(cdk::expression_node *const condition, int lbl, bool when, int lvl) {
+  using jump = void (til::postfix_buffer::*)(const std::string &);
+
+  auto value = _annotations.folded(condition);
+  if (value != nullptr && std::holds_alternative<int>(*value)) {
+    if ((std::get<int>(*value) != 0) == when) {
+      _pf.JMP(mklbl(lbl));
+    }
+    return;
+  }
+  if (auto equivalent = _annotations.simplified(condition)) {
+    writeJump(equivalent, lbl, when, lvl);
+    return;
+  }
+
+  if (auto negation = dynamic_cast<cdk::not_node*>(condition)) {
+    writeJump(negation->argument(), lbl, !when, lvl);
+    return;
+  }
+
+  // short-circuit: only when the bitwise result is also the logical one
+  auto conjunction = dynamic_cast<cdk::and_node*>(condition);
+  auto disjunction = dynamic_cast<cdk::or_node*>(condition);
+  if ((conjunction || disjunction) && boolean(condition)) {
+    auto logical = dynamic_cast<cdk::binary_operation_node*>(condition);
+    if (when == (disjunction != nullptr)) {
+      // a || b jumps if either does; !(a && b) jumps if either is false
+      writeJump(logical->left(), lbl, when, lvl + 2);
+      writeJump(logical->right(), lbl, when, lvl + 2);
+    } else {
+      // a && b: both must be true; !(a || b): both must be false
+      int skip = ++_lbl;
+      writeJump(logical->left(), skip, !when, lvl + 2);
+      writeJump(logical->right(), lbl, when, lvl + 2);
+      _pf.LABEL(mklbl(skip));
+    }
+    return;
+  }
+
+  jump taken = nullptr, untaken = nullptr;
+  if (dynamic_cast<cdk::lt_node*>(condition)) {
+    taken = &til::postfix_buffer::JLT, untaken = &til::postfix_buffer::JGE;
+  } else if (dynamic_cast<cdk::le_node*>(condition)) {
+    taken = &til::postfix_buffer::JLE, untaken = &til::postfix_buffer::JGT;
+  } else if (dynamic_cast<cdk::gt_node*>(condition)) {
+    taken = &til::postfix_buffer::JGT, untaken = &til::postfix_buffer::JLE;
+  } else if (dynamic_cast<cdk::ge_node*>(condition)) {
+    taken = &til::postfix_buffer::JGE, untaken = &til::postfix_buffer::JLT;
+  } else if (dynamic_cast<cdk::eq_node*>(condition)) {
+    taken = &til::postfix_buffer::JEQ, untaken = &til::postfix_buffer::JNE;
+  } else if (dynamic_cast<cdk::ne_node*>(condition)) {
+    taken = &til::postfix_buffer::JNE, untaken = &til::postfix_buffer::JEQ;
+  }
+
+  if (taken == nullptr) {
+    condition->accept(this, lvl);
+    if (when) _pf.JNZ(mklbl(lbl));
+    else _pf.JZ(mklbl(lbl));
+    return;
+  }
+
+  // comparisons: doubles are compared by DCMP, whose result is then compared with 0
+  auto comparison = dynamic_cast<cdk::binary_operation_node*>(condition);
+  comparison->left()->accept(this, lvl + 2);
+  if (comparison->left()->is_typed(cdk::TYPE_INT) && comparison->right()->is_typed(cdk::TYPE_DOUBLE)) {
+    _pf.I2D();
+  }
+  comparison->right()->accept(this, lvl + 2);
+  if (comparison->left()->is_typed(cdk::TYPE_DOUBLE) && comparison->right()->is_typed(cdk::TYPE_INT)) {
+    _pf.I2D();
+  }
+  if (comparison->left()->is_typed(cdk::TYPE_DOUBLE) || comparison->right()->is_typed(cdk::TYPE_DOUBLE)) {
+    _pf.DCMP();
+    _pf.INT(0);
+  }
+  (_pf.*(when ? taken : untaken))(mklbl(lbl));
+}
+
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::acceptAndCast(std::shared_ptr<cdk::basic_type> const type, cdk::expression_node *const node, int lvl) {
@@ -47,7 +206,7 @@ void til::postfix_writer::acceptAndCast(std::shared_ptr<cdk::basic_type> const t
 
   int lineno = node->lineno();
 
-  std::string aux_name = "aux_" + std::to_string(++_lbl);
+  std::string aux_name = "aux" + mklbl(++_lbl);
   til::declaration_node *aux_decl = new til::declaration_node(lineno, tPRIVATE, node_type, aux_name, nullptr);
   cdk::variable_node *aux_var = new cdk::variable_node(lineno, aux_name);
 
@@ -56,7 +215,7 @@ void til::postfix_writer::acceptAndCast(std::shared_ptr<cdk::basic_type> const t
   _outsideFunction = false;
 
   if (inFunction()) { 
-    _pf.TEXT(_functionLabels.top());
+    _pf.TEXT(mklbl(_functionLabels.top()));
   } else {
     _pf.DATA();
   }
@@ -72,10 +231,10 @@ void til::postfix_writer::acceptAndCast(std::shared_ptr<cdk::basic_type> const t
   for (size_t i = 0; i < intended_type->input_length(); i++) {
     std::string argument_name = "_arg" + std::to_string(i);
     til::declaration_node *argument_declaration = new til::declaration_node(lineno, tPRIVATE, intended_type->input(i), argument_name, nullptr);
-    arguments = new cdk::sequence_node(lineno, argument_declaration, arguments);
+    arguments->nodes().push_back(argument_declaration);
     
     cdk::rvalue_node *argument_rvalue = new cdk::rvalue_node(lineno, new cdk::variable_node(lineno, argument_name));
-    call_arguments = new cdk::sequence_node(lineno, argument_rvalue, call_arguments);
+    call_arguments->nodes().push_back(argument_rvalue);
   }
 
   til::function_call_node *call = new til::function_call_node(lineno, aux_rvalue, call_arguments);
@@ -95,14 +254,16 @@ void til::postfix_writer::do_data_node(cdk::data_node * const node, int lvl) {
   // EMPTY
 }
 void til::postfix_writer::do_not_node(cdk::not_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->argument()->accept(this, lvl);
   _pf.INT(0);
   _pf.EQ();
 }
 void til::postfix_writer::do_and_node(cdk::and_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   int lbl;
   node->left()->accept(this, lvl + 2);
@@ -114,7 +275,8 @@ void til::postfix_writer::do_and_node(cdk::and_node * const node, int lvl) {
   _pf.LABEL(mklbl(lbl));
 }
 void til::postfix_writer::do_or_node(cdk::or_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   int lbl;
   node->left()->accept(this, lvl + 2);
@@ -163,7 +325,7 @@ void til::postfix_writer::do_string_node(cdk::string_node * const node, int lvl)
   _pf.SSTRING(node->value()); // output string characters
 
   if (inFunction()) {
-    _pf.TEXT(_functionLabels.top());
+    _pf.TEXT(mklbl(_functionLabels.top()));
     _pf.ADDR(mklbl(lbl));
   } else {
     _pf.DATA();
@@ -174,7 +336,8 @@ void til::postfix_writer::do_string_node(cdk::string_node * const node, int lvl)
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_unary_minus_node(cdk::unary_minus_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->argument()->accept(this, lvl); // determine the value
 
@@ -185,31 +348,35 @@ void til::postfix_writer::do_unary_minus_node(cdk::unary_minus_node * const node
 }
 
 void til::postfix_writer::do_unary_plus_node(cdk::unary_plus_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
   node->argument()->accept(this, lvl); // determine the value
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_add_node(cdk::add_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
-  node->left()->accept(this, lvl);
-  if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
-    _pf.I2D();
-  } else if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
+  if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
     std::shared_ptr<cdk::reference_type> ref = cdk::reference_type::cast(node->type());
-    _pf.INT(std::max(ref->referenced()->size(), static_cast<size_t>(1)));
-    _pf.MUL();
+    writeScaled(node->left(), std::max(ref->referenced()->size(), static_cast<size_t>(1)), lvl);
+  } else {
+    node->left()->accept(this, lvl);
+    if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
+      _pf.I2D();
+    }
   }
 
-  node->right()->accept(this, lvl);
-  if (node->right()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
-    _pf.I2D();
-  } else if (node->right()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
+  if (node->right()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
     std::shared_ptr<cdk::reference_type> ref = cdk::reference_type::cast(node->type());
-    _pf.INT(std::max(ref->referenced()->size(), static_cast<size_t>(1)));
-    _pf.MUL();
+    writeScaled(node->right(), std::max(ref->referenced()->size(), static_cast<size_t>(1)), lvl);
+  } else {
+    node->right()->accept(this, lvl);
+    if (node->right()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
+      _pf.I2D();
+    }
   }
 
   if (node->is_typed(cdk::TYPE_DOUBLE)) {
@@ -220,24 +387,27 @@ void til::postfix_writer::do_add_node(cdk::add_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_sub_node(cdk::sub_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
-  node->left()->accept(this, lvl);
-  if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
-    _pf.I2D();
-  } else if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
+  if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_POINTER)) {
     std::shared_ptr<cdk::reference_type> ref = cdk::reference_type::cast(node->type());
-    _pf.INT(std::max(static_cast<size_t>(1), ref->referenced()->size()));
-    _pf.MUL();
+    writeScaled(node->left(), std::max(static_cast<size_t>(1), ref->referenced()->size()), lvl);
+  } else {
+    node->left()->accept(this, lvl);
+    if (node->left()->is_typed(cdk::TYPE_INT) && node->is_typed(cdk::TYPE_DOUBLE)) {
+      _pf.I2D();
+    }
   }
 
-  node->right()->accept(this, lvl);
-  if (node->is_typed(cdk::TYPE_DOUBLE) && node->right()->is_typed(cdk::TYPE_INT)) {
-    _pf.I2D();
-  } else if (node->is_typed(cdk::TYPE_POINTER) && node->right()->is_typed(cdk::TYPE_INT)) {
+  if (node->is_typed(cdk::TYPE_POINTER) && node->right()->is_typed(cdk::TYPE_INT)) {
     std::shared_ptr<cdk::reference_type> ref = cdk::reference_type::cast(node->type());
-    _pf.INT(std::max(static_cast<size_t>(1), ref->referenced()->size()));
-    _pf.MUL();
+    writeScaled(node->right(), std::max(static_cast<size_t>(1), ref->referenced()->size()), lvl);
+  } else {
+    node->right()->accept(this, lvl);
+    if (node->is_typed(cdk::TYPE_DOUBLE) && node->right()->is_typed(cdk::TYPE_INT)) {
+      _pf.I2D();
+    }
   }
 
   if (node->is_typed(cdk::TYPE_DOUBLE)) {
@@ -254,7 +424,8 @@ void til::postfix_writer::do_sub_node(cdk::sub_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_mul_node(cdk::mul_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE))
@@ -271,7 +442,8 @@ void til::postfix_writer::do_mul_node(cdk::mul_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_div_node(cdk::div_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE))
@@ -288,14 +460,16 @@ void til::postfix_writer::do_div_node(cdk::div_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_mod_node(cdk::mod_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
   node->left()->accept(this, lvl);
   node->right()->accept(this, lvl);
   _pf.MOD();
 }
 
 void til::postfix_writer::do_lt_node(cdk::lt_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -316,7 +490,8 @@ void til::postfix_writer::do_lt_node(cdk::lt_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_le_node(cdk::le_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -337,7 +512,8 @@ void til::postfix_writer::do_le_node(cdk::le_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_ge_node(cdk::ge_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -358,7 +534,8 @@ void til::postfix_writer::do_ge_node(cdk::ge_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_gt_node(cdk::gt_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -379,7 +556,8 @@ void til::postfix_writer::do_gt_node(cdk::gt_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_ne_node(cdk::ne_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -400,7 +578,8 @@ void til::postfix_writer::do_ne_node(cdk::ne_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_eq_node(cdk::eq_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   node->left()->accept(this, lvl);
   if (node->left()->is_typed(cdk::TYPE_INT) && node->right()->is_typed(cdk::TYPE_DOUBLE)) {
@@ -423,9 +602,9 @@ void til::postfix_writer::do_eq_node(cdk::eq_node * const node, int lvl) {
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_variable_node(cdk::variable_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
-  
-  auto symbol = _symtab.find(node->name());
+  ASSERT_CHECKED;
+
+  auto symbol = resolve(node, node->name());
 
   if (symbol->qualifier() == tEXTERNAL) {
     _externalFunctionName  = symbol->name();
@@ -437,7 +616,7 @@ void til::postfix_writer::do_variable_node(cdk::variable_node * const node, int
 }
 
 void til::postfix_writer::do_rvalue_node(cdk::rvalue_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   node->lvalue()->accept(this, lvl);
   
   if (_externalFunctionName) {
@@ -452,7 +631,7 @@ void til::postfix_writer::do_rvalue_node(cdk::rvalue_node * const node, int lvl)
 }
 
 void til::postfix_writer::do_assignment_node(cdk::assignment_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   acceptAndCast(node->type(), node->rvalue(), lvl);
 
@@ -474,9 +653,9 @@ void til::postfix_writer::do_assignment_node(cdk::assignment_node * const node,
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_program_node(til::program_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_DECLARED;
 
-  _functionLabels.push("_main");
+  _functionLabels.push(0); // label 0 is "_main"
 
   // generate the main function (RTS mandates that its name be "_main")
   _pf.TEXT("_main");
@@ -485,50 +664,51 @@ void til::postfix_writer::do_program_node(til::program_node * const node, int lv
   _pf.LABEL("_main");
 
   int oldOffset = _offset;
+  int oldFrameLow = _frameLow;
+  size_t oldFrameUnshared = _frameUnshared;
   _offset = 8;  // space for frame pointer and return address
   _symtab.push(); // enter a new scope
 
-  frame_size_calculator lsc(_compiler, _symtab);
-  node->statements()->accept(&lsc, lvl);
-  _pf.ENTER(lsc.localsize());
+  size_t enter = _pf.ENTER(); // the frame size is known at the end
 
-  std::string _oldFunctionReturnLabel = _functionReturnLabel;
-  _functionReturnLabel = mklbl(++_lbl);
+  int _oldFunctionReturnLabel = _functionReturnLabel;
+  _functionReturnLabel = ++_lbl;
 
-  std::vector<std::string> oldFunctionLoopConditionLabels = _functionLoopConditionLabels;
-  std::vector<std::string> oldFunctionLoopEndLabels = _functionLoopEndLabels;
+  std::vector<int> oldFunctionLoopConditionLabels = _functionLoopConditionLabels;
+  std::vector<int> oldFunctionLoopEndLabels = _functionLoopEndLabels;
 
   _functionLoopConditionLabels.clear();
   _functionLoopEndLabels.clear();
 
   _offset = 0;
+  _frameLow = 0;
+  _frameUnshared = 0;
 
   node->statements()->accept(this, lvl);
+  closeFrame(enter);
 
   // end the main function
   _pf.INT(0);
   _pf.STFVAL32();
   _pf.ALIGN();
-  _pf.LABEL(_functionReturnLabel);
+  _pf.LABEL(mklbl(_functionReturnLabel));
   _pf.LEAVE();
   _pf.RET();
 
   _offset = oldOffset;
+  _frameLow = oldFrameLow;
+  _frameUnshared = oldFrameUnshared;
   _symtab.pop();
   _functionLoopConditionLabels = oldFunctionLoopConditionLabels;
   _functionLoopEndLabels = oldFunctionLoopEndLabels;
   _functionReturnLabel = _oldFunctionReturnLabel;
   _functionLabels.pop();
-
-  for (std::string s : _externalFunctions) {
-    _pf.EXTERN(s);
-  }
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_evaluation_node(til::evaluation_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   node->argument()->accept(this, lvl);
   if (node->argument()->type()->size() > 0) {
@@ -537,7 +717,7 @@ void til::postfix_writer::do_evaluation_node(til::evaluation_node * const node,
 }
 
 void til::postfix_writer::do_print_node(til::print_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   for (size_t i = 0; i < node->argument()->size(); i++) {
     auto expr = dynamic_cast<cdk::expression_node*>(node->argument()->node(i));
@@ -545,22 +725,22 @@ void til::postfix_writer::do_print_node(til::print_node * const node, int lvl) {
     expr->accept(this, lvl);
 
     if (expr->is_typed(cdk::TYPE_INT)) {
-      _externalFunctions.insert("printi");
+      _externalFunctions["printi"] = true;
       _pf.CALL("printi");
       _pf.TRASH(4);
     } else if (expr->is_typed(cdk::TYPE_DOUBLE)) {
-      _externalFunctions.insert("printd");
+      _externalFunctions["printd"] = true;
       _pf.CALL("printd");
       _pf.TRASH(8);
     } else if (expr->is_typed(cdk::TYPE_STRING)) {
-      _externalFunctions.insert("prints");
+      _externalFunctions["prints"] = true;
       _pf.CALL("prints");
       _pf.TRASH(4);
     }
   }
 
   if (node->newline()){
-    _externalFunctions.insert("println");
+    _externalFunctions["println"] = true;
     _pf.CALL("println");
   }
 }
@@ -568,14 +748,14 @@ void til::postfix_writer::do_print_node(til::print_node * const node, int lvl) {
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_read_node(til::read_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   if (node->is_typed(cdk::TYPE_DOUBLE)) {
-    _externalFunctions.insert("readd");
+    _externalFunctions["readd"] = true;
     _pf.CALL("readd");
     _pf.LDFVAL64();
   } else {
-    _externalFunctions.insert("readi");
+    _externalFunctions["readi"] = true;
     _pf.CALL("readi");
     _pf.LDFVAL32();
   }
@@ -583,24 +763,27 @@ void til::postfix_writer::do_read_node(til::read_node * const node, int lvl) {
 
 //---------------------------------------------------------------------------
 
+// rotated loop: a jump to the test at the bottom, which jumps back to the body (a
+// single branch per iteration); "next" goes to the test
 void til::postfix_writer::do_loop_node(til::loop_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   
-  int condition_lbl, end_lbl;
+  int body_lbl, condition_lbl, end_lbl;
 
+  body_lbl = ++_lbl;
   condition_lbl = ++_lbl;
   end_lbl = ++_lbl;
-  _functionLoopConditionLabels.push_back(mklbl(condition_lbl));
-  _functionLoopEndLabels.push_back(mklbl(end_lbl));
+  _functionLoopConditionLabels.push_back(condition_lbl);
+  _functionLoopEndLabels.push_back(end_lbl);
 
-  _pf.ALIGN();
-  _pf.LABEL(mklbl(condition_lbl));
-  node->condition()->accept(this, lvl);
-  _pf.JZ(mklbl(end_lbl));
+  _pf.JMP(mklbl(condition_lbl));
 
+  // no ALIGN: the body and the test are only jumped to (see peephole's align-label)
+  _pf.LABEL(mklbl(body_lbl));
   node->block()->accept(this, lvl + 2);
 
-  _pf.JMP(mklbl(condition_lbl));
+  _pf.LABEL(mklbl(condition_lbl));
+  writeJump(node->condition(), body_lbl, true, lvl);
   _pf.ALIGN();
   _pf.LABEL(mklbl(end_lbl));
 
@@ -614,10 +797,9 @@ void til::postfix_writer::do_loop_node(til::loop_node * const node, int lvl) {
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_if_node(til::if_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   int lbl1;
-  node->condition()->accept(this, lvl);
-  _pf.JZ(mklbl(lbl1 = ++_lbl));
+  writeJump(node->condition(), lbl1 = ++_lbl, false, lvl);
   node->block()->accept(this, lvl + 2);
   _controlFlowAltered = false;
   _pf.ALIGN();
@@ -625,10 +807,9 @@ void til::postfix_writer::do_if_node(til::if_node * const node, int lvl) {
 }
 
 void til::postfix_writer::do_if_else_node(til::if_else_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   int lbl1, lbl2;
-  node->condition()->accept(this, lvl);
-  _pf.JZ(mklbl(lbl1 = ++_lbl));
+  writeJump(node->condition(), lbl1 = ++_lbl, false, lvl);
   node->thenblock()->accept(this, lvl + 2);
   _controlFlowAltered = false;
   _pf.JMP(mklbl(lbl2 = ++_lbl));
@@ -643,24 +824,23 @@ void til::postfix_writer::do_if_else_node(til::if_else_node * const node, int lv
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_declaration_node(til::declaration_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_DECLARED;
   auto symbol = new_symbol();
   reset_new_symbol();
 
-  int offset = 0;
+  // only local symbols get an offset: global ones keep 0, and are shared by the
+  // units written in parallel (see symbol::global())
   int typesize = node->type()->size();
   if (_inFunctionArgs) {
-    offset = _offset;
+    symbol->offset(_offset);
     _offset += typesize;
   } else if (inFunction()) {
     _offset -= typesize;
-    offset = _offset;
-  } else {
-    offset = 0;
+    symbol->offset(_offset);
+    _frameLow = std::min(_frameLow, _offset);
+    _frameUnshared += typesize;
   }
 
-  symbol->offset(offset);
-
   if (inFunction()) {
     if (_inFunctionArgs || node->initialValue() == nullptr) {
       return;
@@ -679,11 +859,11 @@ void til::postfix_writer::do_declaration_node(til::declaration_node * const node
   }
 
   if (symbol->qualifier() == tFORWARD || symbol->qualifier() == tEXTERNAL) {
-    _externalFunctions.insert(symbol->name());
+    _externalFunctions[symbol->name()] = true;
     return;
   }
 
-  _externalFunctions.erase(symbol->name());
+  _externalFunctions[symbol->name()] = false;
 
   if (node->initialValue() == nullptr) {
     _pf.BSS();
@@ -707,20 +887,23 @@ void til::postfix_writer::do_declaration_node(til::declaration_node * const node
 
   _pf.LABEL(symbol->name());
 
-  if (node->is_typed(cdk::TYPE_DOUBLE) && node->initialValue()->is_typed(cdk::TYPE_INT)) {
-    auto int_node = dynamic_cast<cdk::integer_node*>(node->initialValue());
-    _pf.SDOUBLE(int_node->value());
+  // constant initializers (folded while typing) go straight to the data segment
+  auto value = _annotations.folded(node->initialValue());
+  if (value != nullptr && node->is_typed(cdk::TYPE_DOUBLE)) {
+    _pf.SDOUBLE(std::visit([](auto v) { return static_cast<double>(v); }, *value));
+  } else if (value != nullptr && std::holds_alternative<int>(*value)) {
+    _pf.SINT(std::get<int>(*value));
   } else node->initialValue()->accept(this, lvl);
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_function_call_node(til::function_call_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   std::shared_ptr<cdk::functional_type> func_type = 
     (node->identifier() == nullptr) ? 
-    cdk::functional_type::cast(_symtab.find("@", 1)->type()) : 
+    cdk::functional_type::cast(resolve(node, "@", 1)->type()) : 
     cdk::functional_type::cast(node->identifier()->type());
 
   int args_size = 0;
@@ -734,7 +917,7 @@ void til::postfix_writer::do_function_call_node(til::function_call_node * const
 
   _externalFunctionName = std::nullopt;
   if (node->identifier() == nullptr) {
-    _pf.ADDR(_functionLabels.top());
+    _pf.ADDR(mklbl(_functionLabels.top()));
   } else {
     node->identifier()->accept(this, lvl);
   }
@@ -763,16 +946,18 @@ void til::postfix_writer::do_function_call_node(til::function_call_node * const
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_function_node(til::function_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_DECLARED;
 
-  std::string newfunctionLabel = mklbl(++_lbl);
+  int newfunctionLabel = ++_lbl;
   _functionLabels.push(newfunctionLabel);
 
-  _pf.TEXT(_functionLabels.top());
+  _pf.TEXT(mklbl(_functionLabels.top()));
   _pf.ALIGN();
-  _pf.LABEL(_functionLabels.top());
+  _pf.LABEL(mklbl(_functionLabels.top()));
 
   int oldOffset = _offset;
+  int oldFrameLow = _frameLow;
+  size_t oldFrameUnshared = _frameUnshared;
   _offset = 8;  // space for frame pointer and return address
   _symtab.push(); // enter a new scope
 
@@ -780,53 +965,56 @@ void til::postfix_writer::do_function_node(til::function_node * const node, int
   node->arguments()->accept(this, lvl);
   _inFunctionArgs = false;
 
-  frame_size_calculator lsc(_compiler, _symtab);
-  node->block()->accept(&lsc, lvl);
-  _pf.ENTER(lsc.localsize());
+  size_t enter = _pf.ENTER(); // the frame size is known at the end
 
-  std::string _oldFunctionReturnLabel = _functionReturnLabel;
-  _functionReturnLabel = mklbl(++_lbl);
+  int _oldFunctionReturnLabel = _functionReturnLabel;
+  _functionReturnLabel = ++_lbl;
 
-  std::vector<std::string> oldFunctionLoopConditionLabels = _functionLoopConditionLabels;
-  std::vector<std::string> oldFunctionLoopEndLabels = _functionLoopEndLabels;
+  std::vector<int> oldFunctionLoopConditionLabels = _functionLoopConditionLabels;
+  std::vector<int> oldFunctionLoopEndLabels = _functionLoopEndLabels;
 
   _functionLoopConditionLabels.clear();
   _functionLoopEndLabels.clear();
 
   _offset = 0;
+  _frameLow = 0;
+  _frameUnshared = 0;
 
   node->block()->accept(this, lvl);
+  closeFrame(enter);
 
   _pf.ALIGN();
-  _pf.LABEL(_functionReturnLabel);
+  _pf.LABEL(mklbl(_functionReturnLabel));
   _pf.LEAVE();
   _pf.RET();
 
   _functionReturnLabel = _oldFunctionReturnLabel;
 
   _offset = oldOffset;
+  _frameLow = oldFrameLow;
+  _frameUnshared = oldFrameUnshared;
   _functionLoopConditionLabels = oldFunctionLoopConditionLabels;
   _functionLoopEndLabels = oldFunctionLoopEndLabels;
   _functionLabels.pop();
   _symtab.pop();
   
   if (_inFunctionBody){
-    _pf.TEXT(_functionLabels.top());
-    _pf.ADDR(newfunctionLabel);
+    _pf.TEXT(mklbl(_functionLabels.top()));
+    _pf.ADDR(mklbl(newfunctionLabel));
     return;
   }
 
   _pf.DATA();
-  _pf.SADDR(newfunctionLabel);
+  _pf.SADDR(mklbl(newfunctionLabel));
 
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_return_node(til::return_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
-  auto symbol = _symtab.find("@", 1);
+  auto symbol = resolve(node, "@", 1);
   std::shared_ptr<cdk::basic_type> return_type = cdk::functional_type::cast(symbol->type())->output(0);
 
   if (return_type->name() != cdk::TYPE_VOID) {
@@ -839,13 +1027,13 @@ void til::postfix_writer::do_return_node(til::return_node * const node, int lvl)
     }
   }
 
-  _pf.JMP(_functionReturnLabel);
+  _pf.JMP(mklbl(_functionReturnLabel));
 
   _controlFlowAltered = true;
 }
 
 //---------------------------------------------------------------------------
-void til::postfix_writer::handleLoopControlInstruction(int level, const std::vector<std::string>& labels,
+void til::postfix_writer::handleLoopControlInstruction(int level, const std::vector<int>& labels,
                                                           const std::string& instructionName) {
   if (level <= 0) {
     std::cerr << "ERROR: Invalid " << instructionName << " instruction level" << std::endl;
@@ -858,19 +1046,18 @@ void til::postfix_writer::handleLoopControlInstruction(int level, const std::vec
   }
 
   auto index = labels.size() - static_cast<size_t>(level);
-  auto label = labels[index];
-  _pf.JMP(label);
+  _pf.JMP(mklbl(labels[index]));
 
   _controlFlowAltered = true;
 }
 
 void til::postfix_writer::do_next_node(til::next_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   handleLoopControlInstruction(node->level(), _functionLoopConditionLabels, "next");
 }
 
 void til::postfix_writer::do_stop_node(til::stop_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   handleLoopControlInstruction(node->level(), _functionLoopEndLabels, "stop");
 }
 
@@ -878,6 +1065,7 @@ void til::postfix_writer::do_stop_node(til::stop_node * const node, int lvl) {
 
 void til::postfix_writer::do_block_node(til::block_node * const node, int lvl) {
   _symtab.push();
+  int offset = _offset; // the block's locals are gone at its end: later blocks reuse their slots
 
   node->declarations()->accept(this, lvl + 2);
 
@@ -892,13 +1080,15 @@ void til::postfix_writer::do_block_node(til::block_node * const node, int lvl) {
   }
   _controlFlowAltered = false;
 
+  _offset = offset;
   _symtab.pop();
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_sizeof_node(til::sizeof_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
+  FOLDED;
 
   _pf.INT(node->expression()->type()->size());
 }
@@ -906,13 +1096,10 @@ void til::postfix_writer::do_sizeof_node(til::sizeof_node * const node, int lvl)
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_objects_node(til::objects_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
 
   auto referenced = cdk::reference_type::cast(node->type())->referenced();
-  node->argument()->accept(this, lvl);
-
-  _pf.INT(referenced->size());
-  _pf.MUL();
+  writeScaled(node->argument(), referenced->size(), lvl);
   _pf.ALLOC();
   _pf.SP();
 }
@@ -920,7 +1107,7 @@ void til::postfix_writer::do_objects_node(til::objects_node * const node, int lv
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_null_ptr_node(til::null_ptr_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   if (_inFunctionBody) {
     _pf.INT(0);
   } else {
@@ -931,17 +1118,15 @@ void til::postfix_writer::do_null_ptr_node(til::null_ptr_node * const node, int
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_ptr_index_node(til::ptr_index_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   node->base()->accept(this, lvl + 2);
-  node->index()->accept(this, lvl + 2);
-  _pf.INT(node->type()->size());
-  _pf.MUL();
+  writeScaled(node->index(), node->type()->size(), lvl + 2);
   _pf.ADD();
 }
 
 //---------------------------------------------------------------------------
 
 void til::postfix_writer::do_address_of_node(til::address_of_node * const node, int lvl) {
-  ASSERT_SAFE_EXPRESSIONS;
+  ASSERT_CHECKED;
   node->lvalue()->accept(this, lvl + 2);
 }
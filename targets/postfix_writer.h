@@ -2,60 +2,105 @@
 #define __TIL_TARGETS_POSTFIX_WRITER_H__
 
 #include "targets/basic_ast_visitor.h"
+#include "targets/annotations.h"
+#include "targets/postfix_buffer.h"
 
+#include <algorithm>
+#include <charconv>
+#include <map>
 #include <optional>
-#include <sstream>
-#include <set>
 #include <stack>
-#include <cdk/emitters/basic_postfix_emitter.h>
 #include <cdk/types/types.h>
 
 namespace til {
 
   //!
   //! Traverse syntax tree and generate the corresponding assembly code.
+  //! Labels are numbered within a namespace, so that writers for different
+  //! top-level declarations never produce the same label.
   //!
   class postfix_writer: public basic_ast_visitor {
+  public:
+    /** Stack frames written: their bytes, and the bytes they would take if no locals shared slots. */
+    struct frame_usage {
+      size_t frames = 0;
+      size_t bytes = 0;
+      size_t unshared = 0;
+    };
+
+  private:
     cdk::symbol_table<til::symbol> &_symtab;
-    cdk::basic_postfix_emitter &_pf;
+    til::postfix_buffer &_pf;
+    const til::annotations &_annotations;
+    int _namespace; // Label namespace
     int _lbl;
 
     bool _outsideFunction = false; // make future declarations global
-    std::string _functionReturnLabel; // Label used to return from the current function
-    std::set<std::string> _externalFunctions; // External functions to declare
-    std::stack<std::string> _functionLabels; // Stack used to fetch the current function label
+    int _functionReturnLabel; // Label used to return from the current function
+    std::map<std::string, bool> _externalFunctions; // External functions: declare (true) or defined here (false)
+    std::stack<int> _functionLabels; // Stack used to fetch the current function label
     int _offset; // Current framepointer offset
+    int _frameLow = 0; // Lowest offset used by the locals of the current frame
+    size_t _frameUnshared = 0; // Bytes of the locals of the current frame
+    frame_usage _frameUsage;
     std::optional<std::string> _externalFunctionName; // External function to be called
-    std::vector<std::string> _functionLoopConditionLabels;
-    std::vector<std::string> _functionLoopEndLabels;
+    std::vector<int> _functionLoopConditionLabels;
+    std::vector<int> _functionLoopEndLabels;
+    std::vector<std::string> _labels; // Label names, formatted once per label number
     bool _controlFlowAltered = false; // Instructions which alter control flow are stop, next and return
     bool _inFunctionBody = false; // Used to check if we are in a function's body
     bool _inFunctionArgs = false; // Used to check if we are in a function's arguments
 
   public:
     postfix_writer(std::shared_ptr<cdk::compiler> compiler, cdk::symbol_table<til::symbol> &symtab,
-                   cdk::basic_postfix_emitter &pf) :
-        basic_ast_visitor(compiler), _symtab(symtab), _pf(pf), _lbl(0) {
+                   til::postfix_buffer &pf, const til::annotations &annotations, int space = 0) :
+        basic_ast_visitor(compiler), _symtab(symtab), _pf(pf), _annotations(annotations), _namespace(space), _lbl(0),
+        _labels{"_main"} {
+      _labels.reserve(1024);
     }
 
   public:
     ~postfix_writer() {
-      os().flush();
+      // EMPTY: code goes to the postfix buffer, not to os()
+    }
+
+  public:
+    /** External functions referenced (true) or defined (false) by the code written so far. */
+    const std::map<std::string, bool> &externalFunctions() const {
+      return _externalFunctions;
+    }
+
+    const frame_usage &frameUsage() const {
+      return _frameUsage;
     }
 
   protected:
-    void handleLoopControlInstruction(int level, const std::vector<std::string>& labels,
+    void declare(cdk::basic_node *const node);
+    void closeFrame(size_t enter);
+    std::shared_ptr<til::symbol> resolve(cdk::basic_node *const node, const std::string &name, size_t from = 0);
+    void handleLoopControlInstruction(int level, const std::vector<int>& labels,
                                          const std::string& instructionName);
     void acceptAndCast(std::shared_ptr<cdk::basic_type> const type, cdk::expression_node *const node, int lvl);
+    bool writeFolded(cdk::expression_node *const node, int lvl);
+    void writeScaled(cdk::expression_node *const offset, size_t size, int lvl);
+    void writeJump(cdk::expression_node *const condition, int lbl, bool when, int lvl);
+    bool boolean(cdk::expression_node *const node) const;
   private:
-    /** Method used to generate sequential labels. */
-    inline std::string mklbl(int lbl) {
-      std::ostringstream oss;
-      if (lbl < 0)
-        oss << ".L" << -lbl;
-      else
-        oss << "_L" << lbl;
-      return oss.str();
+    /** Name of a sequential label, _L<namespace>_<n> (label 0 is "_main"). Names are kept in a table. */
+    inline const std::string &mklbl(int lbl) {
+      if (static_cast<size_t>(lbl) >= _labels.size()) {
+        _labels.resize(std::max(static_cast<size_t>(lbl) + 1, 2 * _labels.size()));
+      }
+
+      std::string &label = _labels[lbl];
+      if (label.empty()) {
+        char buffer[32] = { '_', 'L' };
+        char *end = std::to_chars(buffer + 2, buffer + sizeof(buffer), _namespace).ptr;
+        *end++ = '_';
+        end = std::to_chars(end, buffer + sizeof(buffer), lbl).ptr;
+        label.assign(buffer, end);
+      }
+      return label;
     }
 
     inline bool inFunction() {
@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <cstring>
+#include "targets/sse2_lowering.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  using opcode = til::postfix_buffer::opcode;
+
+  const size_t registers = 8; // xmm0-xmm7
+
+  std::string xmm(size_t r) {
+    return "xmm" + std::to_string(r);
+  }
+
+  // the double at the address pushed by LOCAL or ADDR ("" for other instructions)
+  std::string variable(const til::postfix_buffer::instruction &ins) {
+    if (ins.op == opcode::LOCAL) return std::string("qword [ebp") + (ins.i < 0 ? "" : "+") + std::to_string(ins.i) + "]";
+    if (ins.op == opcode::ADDR) return "qword [$" + ins.s + "]";
+    return "";
+  }
+
+  // flags of ucomisd (those of an unsigned comparison) for the comparison or jump after DCMP and INT 0
+  const char *condition(opcode op) {
+    switch (op) {
+      case opcode::EQ: case opcode::JEQ: return "e";
+      case opcode::NE: case opcode::JNE: return "ne";
+      case opcode::LT: case opcode::JLT: return "b";
+      case opcode::LE: case opcode::JLE: return "be";
+      case opcode::GT: case opcode::JGT: return "a";
+      case opcode::GE: case opcode::JGE: return "ae";
+      default: return nullptr;
+    }
+  }
+
+  bool jump(opcode op) {
+    return op == opcode::JEQ || op == opcode::JNE || op == opcode::JLT || op == opcode::JLE || op == opcode::JGT
+        || op == opcode::JGE;
+  }
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+void til::sse2_lowering::replay(const postfix_buffer &code) {
+  auto &instructions = code.code();
+  for (size_t k = 0; k < instructions.size(); ) {
+    size_t n = lower(instructions, k);
+    if (n == 0) {
+      flush();
+      postfix_buffer::replay(instructions[k], _pf);
+      n = 1;
+    }
+    k += n;
+  }
+  flush();
+}
+
+void til::sse2_lowering::report(std::ostream &os) const {
+  os << "sse2: " << _lowered << " double instructions, " << _flushed << " doubles written back to the stack" << std::endl;
+}
+
+// Write the instructions at k with SSE2, if they work on doubles.
+// @return how many instructions were written (0 if the one at k is for the emitter)
+size_t til::sse2_lowering::lower(const std::vector<instruction> &code, size_t k) {
+  const instruction &ins = code[k];
+  const instruction *next = k + 1 < code.size() ? &code[k + 1] : nullptr;
+  const instruction *after = k + 2 < code.size() ? &code[k + 2] : nullptr;
+
+  switch (ins.op) {
+    case opcode::LOCAL:
+    case opcode::ADDR:
+      if (next && next->op == opcode::LDDOUBLE) {
+        line("movsd " + push() + ", " + variable(ins));
+      } else if (next && next->op == opcode::STDOUBLE && _cached > 0) {
+        _cached--;
+        line("movsd " + variable(ins) + ", " + xmm(_cached));
+      } else {
+        return 0;
+      }
+      _lowered++;
+      return 2;
+
+    case opcode::DOUBLE: {
+      uint64_t bits;
+      std::memcpy(&bits, &ins.d, sizeof(bits));
+      std::string x = push();
+      line("push dword " + std::to_string(static_cast<uint32_t>(bits >> 32)));
+      line("push dword " + std::to_string(static_cast<uint32_t>(bits)));
+      line("movsd " + x + ", qword [esp]");
+      line("add esp, 8");
+      _lowered++;
+      return 1;
+    }
+
+    case opcode::LDDOUBLE: {
+      if (_cached > 0) return 0; // the address is on the stack, above them
+      line("pop eax");
+      line("movsd " + push() + ", qword [eax]");
+      _lowered++;
+      return 1;
+    }
+
+    case opcode::I2D:
+      if (_cached > 0) return 0;
+      line("cvtsi2sd " + push() + ", dword [esp]");
+      line("add esp, 4");
+      _lowered++;
+      return 1;
+
+    case opcode::DADD: arithmetic("addsd", true); return 1;
+    case opcode::DSUB: arithmetic("subsd", false); return 1;
+    case opcode::DMUL: arithmetic("mulsd", true); return 1;
+    case opcode::DDIV: arithmetic("divsd", false); return 1;
+
+    case opcode::DNEG:
+      // flip the sign bit: with a mask made in the next register, or in memory
+      if (_cached == registers) return 0;
+      if (_cached > 0) {
+        std::string mask = xmm(_cached);
+        line("pcmpeqd " + mask + ", " + mask);
+        line("psllq " + mask + ", 63");
+        line("xorpd " + xmm(_cached - 1) + ", " + mask);
+      } else {
+        line("xor dword [esp+4], 0x80000000");
+      }
+      _lowered++;
+      return 1;
+
+    case opcode::DUP64: {
+      if (_cached == 0 || _cached == registers) return 0;
+      std::string from = xmm(_cached - 1);
+      line("movapd " + push() + ", " + from);
+      _lowered++;
+      return 1;
+    }
+
+    case opcode::TRASH:
+      if (ins.i != 8 || _cached == 0) return 0;
+      _cached--;
+      return 1;
+
+    case opcode::DCMP:
+      compare();
+      _lowered++;
+      if (next && after && next->op == opcode::INT && next->i == 0 && condition(after->op)) {
+        // the registers are written back without touching the flags
+        if (jump(after->op)) {
+          flush();
+          line(std::string("j") + condition(after->op) + " " + after->s);
+        } else {
+          line(std::string("set") + condition(after->op) + " al");
+          line("movzx eax, al");
+          flush();
+          line("push eax");
+        }
+        return 3;
+      }
+      // the sign of the difference
+      line("seta al");
+      line("setb cl");
+      line("movzx eax, al");
+      line("movzx ecx, cl");
+      line("sub eax, ecx");
+      flush();
+      line("push eax");
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+// the two doubles on top of the stack become one (second `operation' top)
+void til::sse2_lowering::arithmetic(const char *operation, bool commutative) {
+  std::string op = operation;
+  if (_cached >= 2) {
+    line(op + " " + xmm(_cached - 2) + ", " + xmm(_cached - 1));
+    _cached--;
+  } else if (_cached == 1 && commutative) {
+    line(op + " xmm0, qword [esp]");
+    line("add esp, 8");
+  } else if (_cached == 1) {
+    line("movsd xmm1, qword [esp]");
+    line("add esp, 8");
+    line(op + " xmm1, xmm0");
+    line("movapd xmm0, xmm1");
+  } else {
+    line("movsd xmm0, qword [esp+8]");
+    line(op + " xmm0, qword [esp]");
+    line("add esp, 16");
+    _cached = 1;
+  }
+  _lowered++;
+}
+
+// the flags of the second double on top of the stack compared with the top one (both taken off)
+void til::sse2_lowering::compare() {
+  if (_cached >= 2) {
+    line("ucomisd " + xmm(_cached - 2) + ", " + xmm(_cached - 1));
+    _cached -= 2;
+  } else if (_cached == 1) {
+    line("movsd xmm1, qword [esp]");
+    line("add esp, 8");
+    line("ucomisd xmm1, xmm0");
+    _cached = 0;
+  } else {
+    line("movsd xmm0, qword [esp+8]");
+    line("ucomisd xmm0, qword [esp]");
+    line("lea esp, [esp+16]");
+  }
+}
+
+// the register of a new double on top of the stack (the others are written back when all are in use)
+std::string til::sse2_lowering::push() {
+  if (_cached == registers) flush();
+  return xmm(_cached++);
+}
+
+// the doubles in registers go back to the stack (the flags are kept)
+void til::sse2_lowering::flush() {
+  if (_cached == 0) return;
+  line("lea esp, [esp-" + std::to_string(8 * _cached) + "]");
+  for (size_t r = 0; r < _cached; r++) {
+    line("movsd qword [esp+" + std::to_string(8 * (_cached - 1 - r)) + "], " + xmm(r));
+  }
+  _flushed += _cached;
+  _cached = 0;
+}
+
+void til::sse2_lowering::line(const std::string &text) {
+  _os << '\t' << text << '\n';
+}
@@ -0,0 +1,57 @@
+#ifndef __TIL_TARGETS_SSE2_LOWERING_H__
+#define __TIL_TARGETS_SSE2_LOWERING_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cdk/emitters/basic_postfix_emitter.h>
+#include "targets/postfix_buffer.h"
+
+namespace til {
+
+  /**
+   * Replay of postfix code to the ix86 emitter with double arithmetic in
+   * SSE2 scalar instructions instead of the emitter's x87 sequences. The
+   * doubles on top of the stack are kept in xmm0-xmm7 (the bottom one in
+   * xmm0) while double instructions use them: loads of variables and
+   * literals go straight to a register, arithmetic works on registers
+   * (addsd, subsd, mulsd, divsd), I2D is cvtsi2sd, DCMP is ucomisd (fused
+   * with the comparison or conditional jump after it), and a store to a
+   * variable, or TRASH, takes the value off. Before any other instruction,
+   * which goes to the emitter, the registers are written back to the
+   * stack, so the emitter always finds the stack it expects.
+   */
+  class sse2_lowering {
+    using instruction = postfix_buffer::instruction;
+    using opcode = postfix_buffer::opcode;
+
+    cdk::basic_postfix_emitter &_pf;
+    std::ostream &_os;
+    size_t _cached = 0;   // doubles on top of the stack that are in xmm0, xmm1, ...
+    size_t _lowered = 0;  // double instructions written with SSE2
+    size_t _flushed = 0;  // doubles written back to the stack
+
+  public:
+    /** `os' is the stream the emitter writes to. */
+    sse2_lowering(cdk::basic_postfix_emitter &pf, std::ostream &os) :
+        _pf(pf), _os(os) {
+    }
+
+  public:
+    void replay(const postfix_buffer &code);
+
+    /** Debug summary: double instructions lowered and doubles written back to the stack. */
+    void report(std::ostream &os) const;
+
+  private:
+    size_t lower(const std::vector<instruction> &code, size_t k);
+    void arithmetic(const char *operation, bool commutative);
+    void compare();
+    std::string push();
+    void flush();
+    void line(const std::string &text);
+  };
+
+} // til
+
+#endif
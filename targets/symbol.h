@@ -4,18 +4,19 @@
 #include <string>
 #include <memory>
 #include <cdk/types/basic_type.h>
+#include "interner.h"
 
 namespace til {
 
   class symbol {
     std::shared_ptr<cdk::basic_type> _type;
-    std::string _name;
+    const std::string *_name; // interned
     int _qualifier;
     int _offset = 0;
 
   public:
     symbol(std::shared_ptr<cdk::basic_type> type, const std::string &name, int qualifier) :
-        _type(type), _name(name), _qualifier(qualifier) {
+        _type(type), _name(&til::interner::instance().intern(name)), _qualifier(qualifier) {
     }
 
     virtual ~symbol() {
@@ -29,7 +30,7 @@ namespace til {
       return _type->name() == name;
     }
     const std::string &name() const {
-      return _name;
+      return *_name;
     }
     int qualifier() const {
       return _qualifier;
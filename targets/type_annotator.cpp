@@ -0,0 +1,309 @@
+#include <string>
+#include "targets/type_annotator.h"
+#include "targets/type_checker.h"
+#include ".auto/all_nodes.h"  // automatically generated
+
+//---------------------------------------------------------------------------
+
+bool til::type_annotator::check(cdk::basic_node *const node) {
+  try {
+    til::type_checker checker(_compiler, _symtab, this);
+    node->accept(&checker, 0);
+  }
+  catch (const std::string &problem) {
+    std::cerr << node->lineno() << ": " << problem << std::endl;
+    _ok = false;
+    return false;
+  }
+
+  _annotations.mark(node);
+  return true;
+}
+
+void til::type_annotator::declare(cdk::basic_node *const node) {
+  // later declarations still need the symbol; the program declares nothing
+  if (auto declaration = dynamic_cast<til::declaration_node*>(node)) {
+    if (!check(declaration)) return;
+    _annotations.symbol(declaration, new_symbol());
+    reset_new_symbol();
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_nil_node(cdk::nil_node * const node, int lvl) {
+  // EMPTY
+}
+void til::type_annotator::do_data_node(cdk::data_node * const node, int lvl) {
+  // EMPTY
+}
+
+void til::type_annotator::processUnaryExpression(cdk::unary_operation_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->argument()->accept(this, lvl + 2);
+}
+
+void til::type_annotator::processBinaryExpression(cdk::binary_operation_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->left()->accept(this, lvl + 2);
+  node->right()->accept(this, lvl + 2);
+}
+
+void til::type_annotator::do_not_node(cdk::not_node * const node, int lvl) {
+  processUnaryExpression(node, lvl);
+}
+void til::type_annotator::do_and_node(cdk::and_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_or_node(cdk::or_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_sequence_node(cdk::sequence_node * const node, int lvl) {
+  for (size_t i = 0; i < node->size(); i++) {
+    node->node(i)->accept(this, lvl);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_integer_node(cdk::integer_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+void til::type_annotator::do_double_node(cdk::double_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+void til::type_annotator::do_string_node(cdk::string_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_unary_minus_node(cdk::unary_minus_node * const node, int lvl) {
+  processUnaryExpression(node, lvl);
+}
+
+void til::type_annotator::do_unary_plus_node(cdk::unary_plus_node * const node, int lvl) {
+  processUnaryExpression(node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_add_node(cdk::add_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_sub_node(cdk::sub_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_mul_node(cdk::mul_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_div_node(cdk::div_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_mod_node(cdk::mod_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_lt_node(cdk::lt_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_le_node(cdk::le_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_ge_node(cdk::ge_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_gt_node(cdk::gt_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_ne_node(cdk::ne_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+void til::type_annotator::do_eq_node(cdk::eq_node * const node, int lvl) {
+  processBinaryExpression(node, lvl);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_variable_node(cdk::variable_node * const node, int lvl) {
+  _annotations.mark(node);
+  _annotations.symbol(node, _symtab.find(node->name()));
+}
+
+void til::type_annotator::do_rvalue_node(cdk::rvalue_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->lvalue()->accept(this, lvl + 2);
+}
+
+void til::type_annotator::do_assignment_node(cdk::assignment_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->rvalue()->accept(this, lvl + 2);
+  node->lvalue()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_program_node(til::program_node * const node, int lvl) {
+  if (!check(node)) return;
+  _annotations.symbol(node, _symtab.find("@"));
+
+  _symtab.push();
+  node->statements()->accept(this, lvl + 2);
+  _symtab.pop();
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_evaluation_node(til::evaluation_node * const node, int lvl) {
+  if (!check(node)) return;
+  node->argument()->accept(this, lvl + 2);
+}
+
+void til::type_annotator::do_print_node(til::print_node * const node, int lvl) {
+  if (!check(node)) return;
+  node->argument()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_read_node(til::read_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_loop_node(til::loop_node * const node, int lvl) {
+  if (!check(node)) return;
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_if_node(til::if_node * const node, int lvl) {
+  if (!check(node)) return;
+  node->condition()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+}
+
+void til::type_annotator::do_if_else_node(til::if_else_node * const node, int lvl) {
+  if (!check(node)) return;
+  node->condition()->accept(this, lvl + 2);
+  node->thenblock()->accept(this, lvl + 2);
+  node->elseblock()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_declaration_node(til::declaration_node * const node, int lvl) {
+  if (!check(node)) return;
+  _annotations.symbol(node, new_symbol());
+  reset_new_symbol();
+
+  if (node->initialValue() != nullptr) {
+    node->initialValue()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_function_call_node(til::function_call_node * const node, int lvl) {
+  _annotations.mark(node);
+  if (node->identifier() == nullptr) {
+    _annotations.symbol(node, _symtab.find("@", 1));
+  }
+
+  // same order as the postfix writer: arguments right-to-left, then the callee
+  for (size_t i = node->arguments()->size(); i > 0; i--) {
+    node->arguments()->node(i - 1)->accept(this, lvl + 2);
+  }
+
+  if (node->identifier() != nullptr) {
+    node->identifier()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_function_node(til::function_node * const node, int lvl) {
+  if (!check(node)) return;
+  _annotations.symbol(node, _symtab.find("@"));
+
+  _symtab.push();
+  node->arguments()->accept(this, lvl + 2);
+  node->block()->accept(this, lvl + 2);
+  _symtab.pop();
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_return_node(til::return_node * const node, int lvl) {
+  if (!check(node)) return;
+  _annotations.symbol(node, _symtab.find("@", 1));
+
+  if (node->value() != nullptr) {
+    node->value()->accept(this, lvl + 2);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_next_node(til::next_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_stop_node(til::stop_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_block_node(til::block_node * const node, int lvl) {
+  _annotations.mark(node);
+
+  _symtab.push();
+  node->declarations()->accept(this, lvl + 2);
+  node->instructions()->accept(this, lvl + 2);
+  _symtab.pop();
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_sizeof_node(til::sizeof_node * const node, int lvl) {
+  // the operand is never evaluated, only its (already checked) type is used
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_objects_node(til::objects_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->argument()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_null_ptr_node(til::null_ptr_node * const node, int lvl) {
+  _annotations.mark(node);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_ptr_index_node(til::ptr_index_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->base()->accept(this, lvl + 2);
+  node->index()->accept(this, lvl + 2);
+}
+
+//---------------------------------------------------------------------------
+
+void til::type_annotator::do_address_of_node(til::address_of_node * const node, int lvl) {
+  _annotations.mark(node);
+  node->lvalue()->accept(this, lvl + 2);
+}
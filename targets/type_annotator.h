@@ -0,0 +1,55 @@
+#ifndef __TIL_TARGETS_TYPE_ANNOTATOR_H__
+#define __TIL_TARGETS_TYPE_ANNOTATOR_H__
+
+#include "targets/basic_ast_visitor.h"
+#include "targets/annotations.h"
+
+namespace til {
+
+  /**
+   * Typing pass: walk the whole tree once, in code generation order, running
+   * the type checker on each declaration and instruction and recording the
+   * results, so that later passes need not check nodes again.
+   */
+  class type_annotator: public basic_ast_visitor {
+    cdk::symbol_table<til::symbol> &_symtab;
+    til::annotations &_annotations;
+    bool _ok = true;
+
+  public:
+    type_annotator(std::shared_ptr<cdk::compiler> compiler, cdk::symbol_table<til::symbol> &symtab,
+                   til::annotations &annotations) :
+        basic_ast_visitor(compiler), _symtab(symtab), _annotations(annotations) {
+    }
+
+  public:
+    ~type_annotator() {
+      os().flush();
+    }
+
+  public:
+    /** Whether every node was checked without errors. */
+    inline bool ok() const {
+      return _ok;
+    }
+
+    /** Type a top-level declaration, but not the code inside it. */
+    void declare(cdk::basic_node *const node);
+
+  protected:
+    bool check(cdk::basic_node *const node);
+    void processUnaryExpression(cdk::unary_operation_node *const node, int lvl);
+    void processBinaryExpression(cdk::binary_operation_node *const node, int lvl);
+
+  public:
+    // do not edit these lines
+#define __IN_VISITOR_HEADER__
+#include ".auto/visitor_decls.h"       // automatically generated
+#undef __IN_VISITOR_HEADER__
+    // do not edit these lines: end
+
+  };
+
+} // til
+
+#endif
@@ -20,7 +20,7 @@ namespace til {
 
   public:
     ~type_checker() {
-      os().flush();
+      // EMPTY
     }
 
   protected:
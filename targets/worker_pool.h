@@ -0,0 +1,96 @@
+#ifndef __TIL_TARGETS_WORKER_POOL_H__
+#define __TIL_TARGETS_WORKER_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace til {
+
+  /**
+   * Threads that stay alive between batches of tasks, so that code written
+   * a few units at a time (see declaration_stream) does not start and join
+   * threads for every batch. The thread that runs a batch works on it too.
+   */
+  class worker_pool {
+    std::vector<std::thread> _threads;
+    std::mutex _lock;
+    std::condition_variable _wake;             // a batch was started, or the pool is stopping
+    std::condition_variable _done;             // every thread is done with the batch
+    const std::function<void(size_t)> *_task = nullptr;
+    size_t _count = 0;                         // tasks in the batch
+    std::atomic<size_t> _next{0};              // next task to take
+    size_t _busy = 0;                          // threads still working on the batch
+    uint64_t _batch = 0;                       // batches started
+    bool _stop = false;
+
+  public:
+    /** A pool with `threads' threads in all (the caller of run() included). */
+    explicit worker_pool(unsigned threads) {
+      for (unsigned t = 1; t < threads; t++) {
+        _threads.emplace_back([this] { work(); });
+      }
+    }
+
+    worker_pool(const worker_pool&) = delete;
+    worker_pool &operator=(const worker_pool&) = delete;
+
+    ~worker_pool() {
+      {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (auto &thread : _threads) {
+        thread.join();
+      }
+    }
+
+    /** Run task(0) to task(count - 1), each once, and return when all are done. */
+    void run(size_t count, const std::function<void(size_t)> &task) {
+      {
+        std::lock_guard<std::mutex> guard(_lock);
+        _task = &task;
+        _count = count;
+        _next = 0;
+        _busy = _threads.size();
+        _batch++;
+      }
+      _wake.notify_all();
+      take();
+      std::unique_lock<std::mutex> lock(_lock);
+      _done.wait(lock, [this] { return _busy == 0; });
+      _task = nullptr;
+    }
+
+  private:
+    // idle threads take the next task, so long ones do not hold up the rest
+    void take() {
+      for (size_t i; (i = _next++) < _count; ) {
+        (*_task)(i);
+      }
+    }
+
+    void work() {
+      uint64_t seen = 0;
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(_lock);
+          _wake.wait(lock, [&] { return _stop || _batch != seen; });
+          if (_stop) return;
+          seen = _batch;
+        }
+        take();
+        std::lock_guard<std::mutex> guard(_lock);
+        if (--_busy == 0) _done.notify_one();
+      }
+    }
+  };
+
+} // til
+
+#endif
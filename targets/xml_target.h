@@ -3,6 +3,10 @@
 
 #include <cdk/targets/basic_target.h>
 #include <cdk/ast/basic_node.h>
+#include "arena.h"
+#include "interner.h"
+#include "timings.h"
+#include "targets/declaration_stream.h"
 #include "targets/xml_writer.h"
 
 namespace til {
@@ -21,8 +25,23 @@ namespace til {
       // an exception will be thrown if identifiers are used before declaration
       cdk::symbol_table<til::symbol> symtab;
 
-      xml_writer writer(compiler, symtab);
-      compiler->ast()->accept(&writer, 0);
+      til::timings::instance().parsed();
+      if (til::declaration_stream::instance().declarations() > 0) {
+        std::cerr << "TIL_STREAM: top-level declarations were compiled and released while parsing" << std::endl;
+        return false;
+      }
+      {
+        til::timings::probe probe(til::timings::XML);
+        xml_writer writer(compiler, symtab);
+        compiler->ast()->accept(&writer, 0);
+      }
+
+      if (compiler->debug()) {
+        til::arena::instance().report(std::cerr);
+        til::interner::instance().report(std::cerr);
+      }
+
+      til::timings::instance().save();
       return true;
     }
 
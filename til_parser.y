@@ -10,6 +10,17 @@
 #define yylex()                      compiler->scanner()->scan()
 #define yyerror(compiler, s)         compiler->scanner()->error(s)
 //-- don't change *any* of these --- END!
+#include "arena.h"
+#include "simd_scanner.h"
+#include "timings.h"
+#include "targets/declaration_stream.h"
+#define ARENA                        til::arena::instance()
+#define STREAM                       til::declaration_stream::instance()
+#define SCANNER                      til::simd_scanner::selected(compiler->ifile())
+#undef  LINE
+#define LINE                         (SCANNER ? SCANNER->lineno() : compiler->scanner()->lineno())
+#undef  yylex
+#define yylex()                      til::timings::instance().scan([&] { return SCANNER ? SCANNER->scan() : compiler->scanner()->scan(); })
 %}
 
 %parse-param {std::shared_ptr<cdk::compiler> compiler}
@@ -26,7 +37,7 @@
 
   int                                            i;          /* integer value */
   double                                         d;          /* integer value */
-  std::string                                   *s;          /* symbol name or string literal */
+  const std::string                             *s;          /* interned symbol name, or string literal (see the scanner) */
   cdk::basic_node                               *node;       /* node pointer */
   cdk::sequence_node                            *sequence;
   cdk::expression_node                          *expression; /* expression nodes */
@@ -58,56 +69,56 @@
 %}
 %%
 
-file : file_decls program { compiler->ast(new cdk::sequence_node(LINE, $2, $1)); }
+file : file_decls program { $1->nodes().push_back($2); compiler->ast($1); }
      | file_decls         { compiler->ast($1); }
-     |            program { compiler->ast(new cdk::sequence_node(LINE, $1)); }
-     | /* empty */        { compiler->ast(new cdk::sequence_node(LINE)); }
+     |            program { compiler->ast(ARENA.node<cdk::sequence_node>(LINE, $1)); }
+     | /* empty */        { compiler->ast(ARENA.node<cdk::sequence_node>(LINE)); }
      ;
 
-file_decls : file_decls file_decl { $$ = new cdk::sequence_node(LINE, $2, $1); }
-           |            file_decl { $$ = new cdk::sequence_node(LINE, $1); }
+file_decls : file_decls file_decl { $$ = $1; STREAM.next(compiler, $$, $2); }
+           |            file_decl { $$ = STREAM.first(compiler, LINE, $1); }
            ;
 
-file_decl : '(' tEXTERNAL type tIDENTIFIER      ')' { $$ = new til::declaration_node(LINE, tEXTERNAL, $3, *$4, nullptr); delete $4; }
-          | '(' tFORWARD  type tIDENTIFIER      ')' { $$ = new til::declaration_node(LINE, tFORWARD,  $3, *$4, nullptr); delete $4; }
-          | '(' tPUBLIC   type tIDENTIFIER      ')' { $$ = new til::declaration_node(LINE, tPUBLIC,   $3, *$4, nullptr); delete $4; }
-          | '(' tPUBLIC   type tIDENTIFIER expr ')' { $$ = new til::declaration_node(LINE, tPUBLIC,   $3, *$4,      $5); delete $4; }
-          | '(' tPUBLIC   tVAR tIDENTIFIER expr ')' { $$ = new til::declaration_node(LINE, tPUBLIC,   nullptr, *$4, $5); delete $4; }
-          | '(' tPUBLIC        tIDENTIFIER expr ')' { $$ = new til::declaration_node(LINE, tPUBLIC,   nullptr, *$3, $4); delete $3; }
+file_decl : '(' tEXTERNAL type tIDENTIFIER      ')' { $$ = ARENA.node<til::declaration_node>(LINE, tEXTERNAL, $3, *$4, nullptr); }
+          | '(' tFORWARD  type tIDENTIFIER      ')' { $$ = ARENA.node<til::declaration_node>(LINE, tFORWARD,  $3, *$4, nullptr); }
+          | '(' tPUBLIC   type tIDENTIFIER      ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPUBLIC,   $3, *$4, nullptr); }
+          | '(' tPUBLIC   type tIDENTIFIER expr ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPUBLIC,   $3, *$4,      $5); }
+          | '(' tPUBLIC   tVAR tIDENTIFIER expr ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPUBLIC,   nullptr, *$4, $5); }
+          | '(' tPUBLIC        tIDENTIFIER expr ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPUBLIC,   nullptr, *$3, $4); }
           | decl                                    { $$ = $1; }
           ;
 
-decls : decls decl { $$ = new cdk::sequence_node(LINE, $2, $1); }
-      |       decl { $$ = new cdk::sequence_node(LINE, $1); }
+decls : decls decl { $$ = $1; $$->nodes().push_back($2); }
+      |       decl { $$ = ARENA.node<cdk::sequence_node>(LINE, $1); }
       ;
 
-decl : '(' type tIDENTIFIER      ')' { $$ = new til::declaration_node(LINE, tPRIVATE, $2, *$3, nullptr); delete $3; }
-     | '(' type tIDENTIFIER expr ')' { $$ = new til::declaration_node(LINE, tPRIVATE, $2, *$3,      $4); delete $3; }
-     | '(' tVAR tIDENTIFIER expr ')' { $$ = new til::declaration_node(LINE, tPRIVATE, nullptr, *$3, $4); delete $3; }
+decl : '(' type tIDENTIFIER      ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPRIVATE, $2, *$3, nullptr); }
+     | '(' type tIDENTIFIER expr ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPRIVATE, $2, *$3,      $4); }
+     | '(' tVAR tIDENTIFIER expr ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPRIVATE, nullptr, *$3, $4); }
      ;
 
-program : '(' tPROGRAM decls_instrs ')' { $$ = new til::program_node(LINE, $3); }
+program : '(' tPROGRAM decls_instrs ')' { $$ = ARENA.node<til::program_node>(LINE, $3); }
         ;
 
-decls_instrs : decls instrs { $$ = new til::block_node(LINE, $1,                           $2); }
-             | decls        { $$ = new til::block_node(LINE, $1,                           new cdk::sequence_node(LINE)); }
-             |       instrs { $$ = new til::block_node(LINE, new cdk::sequence_node(LINE), $1); }
-             | /* empty */  { $$ = new til::block_node(LINE, new cdk::sequence_node(LINE), new cdk::sequence_node(LINE)); }
+decls_instrs : decls instrs { $$ = ARENA.node<til::block_node>(LINE, $1,                                   $2); }
+             | decls        { $$ = ARENA.node<til::block_node>(LINE, $1,                                   ARENA.node<cdk::sequence_node>(LINE)); }
+             |       instrs { $$ = ARENA.node<til::block_node>(LINE, ARENA.node<cdk::sequence_node>(LINE), $1); }
+             | /* empty */  { $$ = ARENA.node<til::block_node>(LINE, ARENA.node<cdk::sequence_node>(LINE), ARENA.node<cdk::sequence_node>(LINE)); }
              ;
 
-func_def : '(' tFUNCTION '(' func_return_type func_args ')' decls_instrs ')' { $$ = new til::function_node(LINE, $5,                           $4, $7); }
-         | '(' tFUNCTION '(' func_return_type           ')' decls_instrs ')' { $$ = new til::function_node(LINE, new cdk::sequence_node(LINE), $4, $6); }
+func_def : '(' tFUNCTION '(' func_return_type func_args ')' decls_instrs ')' { $$ = ARENA.node<til::function_node>(LINE, $5,                                   $4, $7); }
+         | '(' tFUNCTION '(' func_return_type           ')' decls_instrs ')' { $$ = ARENA.node<til::function_node>(LINE, ARENA.node<cdk::sequence_node>(LINE), $4, $6); }
          ;
 
-func_args : func_args func_arg { $$ = new cdk::sequence_node(LINE, $2, $1); }
-          |           func_arg { $$ = new cdk::sequence_node(LINE, $1); }
+func_args : func_args func_arg { $$ = $1; $$->nodes().push_back($2); }
+          |           func_arg { $$ = ARENA.node<cdk::sequence_node>(LINE, $1); }
           ;
 
-func_arg : '(' type tIDENTIFIER ')' { $$ = new til::declaration_node(LINE, tPRIVATE, $2, *$3, nullptr); delete $3; }
+func_arg : '(' type tIDENTIFIER ')' { $$ = ARENA.node<til::declaration_node>(LINE, tPRIVATE, $2, *$3, nullptr); }
          ;
 
 types : types type { $$ = $1; $$->push_back($2); }
-      |       type { $$ = new std::vector<std::shared_ptr<cdk::basic_type>>(1, $1); }
+      |       type { $$ = ARENA.make<std::vector<std::shared_ptr<cdk::basic_type>>>(1, $1); }
       ;
 
 type : referable_type { $$ = $1; }
@@ -125,7 +136,7 @@ ptr_to_type : referable_type '!' { $$ = cdk::reference_type::create(4, $1); }
             ;
 
 func_type : '(' func_return_type               ')' { $$ = cdk::functional_type::create($2); }
-          | '(' func_return_type '(' types ')' ')' { $$ = cdk::functional_type::create(*$4, $2); delete $4; }
+          | '(' func_return_type '(' types ')' ')' { $$ = cdk::functional_type::create(*$4, $2); }
 
 func_return_type : type       { $$ = $1; }
                  | tTYPE_VOID { $$ = cdk::primitive_type::create(0, cdk::TYPE_VOID); }
@@ -136,69 +147,69 @@ void_ptr_type : void_ptr_type '*' { $$ = $1; }
 
 block : '(' tBLOCK decls_instrs ')' { $$ = $3; }
 
-instrs : instrs instr { $$ = new cdk::sequence_node(LINE, $2, $1); }
-       |        instr { $$ = new cdk::sequence_node(LINE, $1); }
+instrs : instrs instr { $$ = $1; $$->nodes().push_back($2); }
+       |        instr { $$ = ARENA.node<cdk::sequence_node>(LINE, $1); }
        ;
 
-instr : expr                           { $$ = new til::evaluation_node(LINE, $1); }
-      | '(' tPRINT   exprs    ')'      { $$ = new til::print_node(LINE, $3, false); }
-      | '(' tPRINTLN exprs    ')'      { $$ = new til::print_node(LINE, $3, true); }
-      | '(' tSTOP    tINTEGER ')'      { $$ = new til::stop_node(LINE, $3); }
-      | '(' tSTOP             ')'      { $$ = new til::stop_node(LINE, 1); }
-      | '(' tNEXT    tINTEGER ')'      { $$ = new til::next_node(LINE, $3); }
-      | '(' tNEXT             ')'      { $$ = new til::next_node(LINE, 1); }
-      | '(' tRETURN  expr     ')'      { $$ = new til::return_node(LINE, $3); }
-      | '(' tRETURN           ')'      { $$ = new til::return_node(LINE, nullptr); }
-      | '(' tIF   expr instr instr ')' { $$ = new til::if_else_node(LINE, $3, $4, $5); }
-      | '(' tIF   expr instr       ')' { $$ = new til::if_node(LINE, $3, $4); }
-      | '(' tLOOP expr instr       ')' { $$ = new til::loop_node(LINE, $3, $4); }
+instr : expr                           { $$ = ARENA.node<til::evaluation_node>(LINE, $1); }
+      | '(' tPRINT   exprs    ')'      { $$ = ARENA.node<til::print_node>(LINE, $3, false); }
+      | '(' tPRINTLN exprs    ')'      { $$ = ARENA.node<til::print_node>(LINE, $3, true); }
+      | '(' tSTOP    tINTEGER ')'      { $$ = ARENA.node<til::stop_node>(LINE, $3); }
+      | '(' tSTOP             ')'      { $$ = ARENA.node<til::stop_node>(LINE, 1); }
+      | '(' tNEXT    tINTEGER ')'      { $$ = ARENA.node<til::next_node>(LINE, $3); }
+      | '(' tNEXT             ')'      { $$ = ARENA.node<til::next_node>(LINE, 1); }
+      | '(' tRETURN  expr     ')'      { $$ = ARENA.node<til::return_node>(LINE, $3); }
+      | '(' tRETURN           ')'      { $$ = ARENA.node<til::return_node>(LINE, nullptr); }
+      | '(' tIF   expr instr instr ')' { $$ = ARENA.node<til::if_else_node>(LINE, $3, $4, $5); }
+      | '(' tIF   expr instr       ')' { $$ = ARENA.node<til::if_node>(LINE, $3, $4); }
+      | '(' tLOOP expr instr       ')' { $$ = ARENA.node<til::loop_node>(LINE, $3, $4); }
       | block                          { $$ = $1; }
       ;
 
-exprs : exprs expr { $$ = new cdk::sequence_node(LINE, $2, $1); }
-      |       expr { $$ = new cdk::sequence_node(LINE, $1); }
+exprs : exprs expr { $$ = $1; $$->nodes().push_back($2); }
+      |       expr { $$ = ARENA.node<cdk::sequence_node>(LINE, $1); }
       ;
 
 expr : // Literal expressions:
-       tINTEGER { $$ = new cdk::integer_node(LINE, $1); }
-     | tDOUBLE  { $$ = new cdk::double_node(LINE, $1); }
-     | tSTRING  { $$ = new cdk::string_node(LINE, $1); }
-     | tNULL    { $$ = new til::null_ptr_node(LINE); }
+       tINTEGER { $$ = ARENA.node<cdk::integer_node>(LINE, $1); }
+     | tDOUBLE  { $$ = ARENA.node<cdk::double_node>(LINE, $1); }
+     | tSTRING  { $$ = ARENA.node<cdk::string_node>(LINE, *$1); }
+     | tNULL    { $$ = ARENA.node<til::null_ptr_node>(LINE); }
        // Functions invocation:
-     | '(' expr exprs ')' { $$ = new til::function_call_node(LINE, $2,      $3); }
-     | '(' expr       ')' { $$ = new til::function_call_node(LINE, $2,      new cdk::sequence_node(LINE)); }
-     | '(' '@'  exprs ')' { $$ = new til::function_call_node(LINE, nullptr, $3); }
-     | '(' '@'        ')' { $$ = new til::function_call_node(LINE, nullptr, new cdk::sequence_node(LINE)); }
+     | '(' expr exprs ')' { $$ = ARENA.node<til::function_call_node>(LINE, $2,      $3); }
+     | '(' expr       ')' { $$ = ARENA.node<til::function_call_node>(LINE, $2,      ARENA.node<cdk::sequence_node>(LINE)); }
+     | '(' '@'  exprs ')' { $$ = ARENA.node<til::function_call_node>(LINE, nullptr, $3); }
+     | '(' '@'        ')' { $$ = ARENA.node<til::function_call_node>(LINE, nullptr, ARENA.node<cdk::sequence_node>(LINE)); }
        // Identifier, read, functions:
-     | lval          { $$ = new cdk::rvalue_node(LINE, $1); }
-     | '(' tREAD ')' { $$ = new til::read_node(LINE); }
+     | lval          { $$ = ARENA.node<cdk::rvalue_node>(LINE, $1); }
+     | '(' tREAD ')' { $$ = ARENA.node<til::read_node>(LINE); }
      | func_def      { $$ = $1; }
        // Operators evaluation table:
-     | '(' '+'  expr      ')' { $$ = new cdk::unary_plus_node(LINE, $3); }
-     | '(' '-'  expr      ')' { $$ = new cdk::unary_minus_node(LINE, $3); }
-     | '(' '?'  lval      ')' { $$ = new til::address_of_node(LINE, $3); }
-     | '(' '*'  expr expr ')' { $$ = new cdk::mul_node(LINE, $3, $4); }
-     | '(' '/'  expr expr ')' { $$ = new cdk::div_node(LINE, $3, $4); }
-     | '(' '%'  expr expr ')' { $$ = new cdk::mod_node(LINE, $3, $4); }
-     | '(' '+'  expr expr ')' { $$ = new cdk::add_node(LINE, $3, $4); }
-     | '(' '-'  expr expr ')' { $$ = new cdk::sub_node(LINE, $3, $4); }
-     | '(' '<'  expr expr ')' { $$ = new cdk::lt_node(LINE, $3, $4); }
-     | '(' '>'  expr expr ')' { $$ = new cdk::gt_node(LINE, $3, $4); }
-     | '(' tLE  expr expr ')' { $$ = new cdk::le_node(LINE, $3, $4); }
-     | '(' tGE  expr expr ')' { $$ = new cdk::ge_node(LINE, $3, $4); }
-     | '(' tEQ  expr expr ')' { $$ = new cdk::eq_node(LINE, $3, $4); }
-     | '(' tNE  expr expr ')' { $$ = new cdk::ne_node(LINE, $3, $4); }
-     | '(' '~'  expr      ')' { $$ = new cdk::not_node(LINE, $3); }
-     | '(' tAND expr expr ')' { $$ = new cdk::and_node(LINE, $3, $4); }
-     | '(' tOR  expr expr ')' { $$ = new cdk::or_node(LINE, $3, $4); }
-     | '(' tSET lval expr ')' { $$ = new cdk::assignment_node(LINE, $3, $4); }
+     | '(' '+'  expr      ')' { $$ = ARENA.node<cdk::unary_plus_node>(LINE, $3); }
+     | '(' '-'  expr      ')' { $$ = ARENA.node<cdk::unary_minus_node>(LINE, $3); }
+     | '(' '?'  lval      ')' { $$ = ARENA.node<til::address_of_node>(LINE, $3); }
+     | '(' '*'  expr expr ')' { $$ = ARENA.node<cdk::mul_node>(LINE, $3, $4); }
+     | '(' '/'  expr expr ')' { $$ = ARENA.node<cdk::div_node>(LINE, $3, $4); }
+     | '(' '%'  expr expr ')' { $$ = ARENA.node<cdk::mod_node>(LINE, $3, $4); }
+     | '(' '+'  expr expr ')' { $$ = ARENA.node<cdk::add_node>(LINE, $3, $4); }
+     | '(' '-'  expr expr ')' { $$ = ARENA.node<cdk::sub_node>(LINE, $3, $4); }
+     | '(' '<'  expr expr ')' { $$ = ARENA.node<cdk::lt_node>(LINE, $3, $4); }
+     | '(' '>'  expr expr ')' { $$ = ARENA.node<cdk::gt_node>(LINE, $3, $4); }
+     | '(' tLE  expr expr ')' { $$ = ARENA.node<cdk::le_node>(LINE, $3, $4); }
+     | '(' tGE  expr expr ')' { $$ = ARENA.node<cdk::ge_node>(LINE, $3, $4); }
+     | '(' tEQ  expr expr ')' { $$ = ARENA.node<cdk::eq_node>(LINE, $3, $4); }
+     | '(' tNE  expr expr ')' { $$ = ARENA.node<cdk::ne_node>(LINE, $3, $4); }
+     | '(' '~'  expr      ')' { $$ = ARENA.node<cdk::not_node>(LINE, $3); }
+     | '(' tAND expr expr ')' { $$ = ARENA.node<cdk::and_node>(LINE, $3, $4); }
+     | '(' tOR  expr expr ')' { $$ = ARENA.node<cdk::or_node>(LINE, $3, $4); }
+     | '(' tSET lval expr ')' { $$ = ARENA.node<cdk::assignment_node>(LINE, $3, $4); }
        // Memory reservation, dimension:
-     | '(' tOBJECTS  expr ')' { $$ = new til::objects_node(LINE, $3); }
-     | '(' tSIZEOF   expr ')' { $$ = new til::sizeof_node(LINE, $3); }
+     | '(' tOBJECTS  expr ')' { $$ = ARENA.node<til::objects_node>(LINE, $3); }
+     | '(' tSIZEOF   expr ')' { $$ = ARENA.node<til::sizeof_node>(LINE, $3); }
      ;
 
-lval : tIDENTIFIER              { $$ = new cdk::variable_node(LINE, $1); }
-     | '(' tINDEX expr expr ')' { $$ = new til::ptr_index_node(LINE, $3, $4); }
+lval : tIDENTIFIER              { $$ = ARENA.node<cdk::variable_node>(LINE, *$1); }
+     | '(' tINDEX expr expr ')' { $$ = ARENA.node<til::ptr_index_node>(LINE, $3, $4); }
      ;
 
 %%
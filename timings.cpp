@@ -0,0 +1,140 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+#include "timings.h"
+#include "options.h"
+
+//---------------------------------------------------------------------------
+
+namespace {
+
+  const char *const names[til::timings::PHASES] = {
+    "scan", "parse", "check", "codegen", "emit", "flush", "xml"
+  };
+
+  // heap allocations, counted only in stats mode
+  bool counting = false;
+  std::atomic<size_t> allocation_count{0};
+  std::atomic<size_t> allocation_bytes{0};
+
+  // small, stable thread numbers for the trace
+  std::atomic<int> threads{0};
+  thread_local int thread_number = threads++;
+
+}
+
+void *operator new(size_t size) {
+  if (counting) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  if (void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+//---------------------------------------------------------------------------
+
+til::timings::timings() :
+    _enabled(!options::instance().times().empty() || !options::instance().stats().empty()),
+    _tracing(!options::instance().stats().empty()), _start(clock::now()) {
+  counting = _tracing;
+}
+
+til::timings &til::timings::instance() {
+  static timings _self;
+  return _self;
+}
+
+// start the clock with the process, not with the first probe
+static til::timings &_process_start = til::timings::instance();
+
+//---------------------------------------------------------------------------
+
+til::timings::allocations til::timings::allocated() {
+  return { allocation_count.load(std::memory_order_relaxed), allocation_bytes.load(std::memory_order_relaxed) };
+}
+
+long til::timings::peak_rss_kb() {
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+void til::timings::parsed() {
+  if (!_enabled || _parse_start == clock::time_point()) return;
+  auto end = clock::now();
+  add(PARSE, end - _parse_start - _parse_paused);
+  _ns[PARSE] -= _ns[SCAN];
+  // the scanner and the parser take turns: one event covers both, the scanner's share is in its arguments
+  if (_tracing) trace(PARSE, _parse_start, end, { 0, 0 });
+}
+
+void til::timings::trace(phase p, clock::time_point start, clock::time_point end, const allocations &before) {
+  allocations after = allocated();
+  event e{p, thread_number, start, end, { after.count - before.count, after.bytes - before.bytes }, peak_rss_kb()};
+
+  std::lock_guard<std::mutex> guard(_events_lock);
+  _events.push_back(e);
+}
+
+//---------------------------------------------------------------------------
+
+void til::timings::report(std::ostream &os) const {
+  os << '{';
+  for (int p = 0; p < PHASES; p++) {
+    os << '"' << names[p] << "\":" << _ns[p] / 1e9 << ',';
+  }
+  os << "\"total\":" << std::chrono::duration<double>(clock::now() - _start).count() << '}' << std::endl;
+}
+
+void til::timings::write_trace(std::ostream &os) {
+  auto us = [this](clock::time_point t) {
+    return std::chrono::duration<double, std::micro>(t - _start).count();
+  };
+
+  std::lock_guard<std::mutex> guard(_events_lock);
+  os << "{\"traceEvents\":[\n";
+  os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"til\"}}";
+  for (const event &e : _events) {
+    os << ",\n{\"name\":\"" << names[e.p] << "\",\"cat\":\"til\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+       << ",\"ts\":" << us(e.start) << ",\"dur\":" << us(e.end) - us(e.start) << ",\"args\":{";
+    if (e.p == PARSE) {
+      os << "\"scan_ms\":" << _ns[SCAN] / 1e6;
+    } else {
+      os << "\"allocations\":" << e.allocated.count << ",\"allocated_bytes\":" << e.allocated.bytes;
+    }
+    os << "}}";
+    os << ",\n{\"name\":\"peak RSS (kB)\",\"ph\":\"C\",\"pid\":1,\"ts\":" << us(e.end)
+       << ",\"args\":{\"rss\":" << e.peak_rss_kb << "}}";
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+void til::timings::save() {
+  if (!options::instance().times().empty()) {
+    std::ofstream os(options::instance().times(), std::ios::app);
+    report(os);
+  }
+
+  if (_tracing) {
+    std::ofstream os(options::instance().stats());
+    write_trace(os);
+
+    allocations total = allocated();
+    std::cerr << "stats: ";
+    for (int p = 0; p < PHASES; p++) {
+      if (_ns[p] != 0) std::cerr << names[p] << ' ' << _ns[p] / 1e6 << " ms, ";
+    }
+    std::cerr << total.count << " allocations (" << total.bytes << " bytes), peak RSS " << peak_rss_kb()
+              << " kB; trace in " << options::instance().stats() << std::endl;
+  }
+}
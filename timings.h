@@ -0,0 +1,139 @@
+#ifndef __TIL_TIMINGS_H__
+#define __TIL_TIMINGS_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace til {
+
+  /**
+   * Time spent in each compiler phase. Timing is off unless requested (see
+   * til::options); when off, each probe costs one test of a flag. Phases run
+   * by several code generation threads add up the time of every thread.
+   *
+   * In stats mode, every probe also becomes an event of a Chrome trace
+   * (chrome://tracing, Perfetto), with the memory allocated while it ran and
+   * the peak resident set size when it ended.
+   */
+  class timings {
+  public:
+    enum phase { SCAN, PARSE, CHECK, CODEGEN, EMIT, FLUSH, XML, PHASES };
+
+    using clock = std::chrono::steady_clock;
+
+    /** Heap allocations since the start (counted only in stats mode). */
+    struct allocations {
+      size_t count;
+      size_t bytes;
+    };
+
+  private:
+    struct event {
+      phase p;
+      int thread;
+      clock::time_point start, end;
+      allocations allocated;
+      long peak_rss_kb;
+    };
+
+    bool _enabled;
+    bool _tracing;
+    clock::time_point _start;            // start of the process
+    clock::time_point _parse_start;      // first token requested by the parser
+    clock::duration _parse_paused{};     // work done inside the parse interval (see pause)
+    std::atomic<int64_t> _ns[PHASES] = {};
+
+    std::mutex _events_lock;
+    std::vector<event> _events;
+
+    timings();
+
+  public:
+    /** The timings of the current compilation. */
+    static timings &instance();
+
+    bool enabled() const {
+      return _enabled;
+    }
+    bool tracing() const {
+      return _tracing;
+    }
+
+    void add(phase p, clock::duration elapsed) {
+      _ns[p] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    /** Time one call to the scanner: the parser's own time is what remains. */
+    template<typename Scan>
+    int scan(Scan &&next_token) {
+      if (!_enabled) return next_token();
+      auto start = clock::now();
+      if (_parse_start == clock::time_point()) _parse_start = start;
+      int token = next_token();
+      add(SCAN, clock::now() - start);
+      return token;
+    }
+
+    /** The parser is done: charge it the time since the first token, minus scanning and pauses. */
+    void parsed();
+
+    /** Add a trace event for a phase that ran between the two instants. */
+    void trace(phase p, clock::time_point start, clock::time_point end, const allocations &before);
+
+    static allocations allocated();
+    static long peak_rss_kb();
+
+    /** Write the phase times, in seconds, as a single-line JSON object. */
+    void report(std::ostream &os) const;
+
+    /** Write the trace events in Chrome's trace event format. */
+    void write_trace(std::ostream &os);
+
+    /** Save what was requested: phase times (TIL_TIMES) and the trace (TIL_STATS). */
+    void save();
+
+    /** Charge the lifetime of the object to a phase. */
+    class probe {
+      phase _phase;
+      clock::time_point _start;
+      allocations _allocated;
+
+    public:
+      explicit probe(phase p) :
+          _phase(p) {
+        if (!instance().enabled()) return;
+        if (instance().tracing()) _allocated = allocated();
+        _start = clock::now();
+      }
+      ~probe() {
+        if (!instance().enabled()) return;
+        auto end = clock::now();
+        instance().add(_phase, end - _start);
+        if (instance().tracing()) instance().trace(_phase, _start, end, _allocated);
+      }
+    };
+
+    /**
+     * Stop the parse clock for the lifetime of the object: the phases run by
+     * the parser's actions (streamed declarations) are not parsing.
+     */
+    class pause {
+      clock::time_point _start;
+
+    public:
+      pause() {
+        if (instance().enabled()) _start = clock::now();
+      }
+      ~pause() {
+        if (instance().enabled()) instance()._parse_paused += clock::now() - _start;
+      }
+    };
+  };
+
+} // til
+
+#endif